@@ -0,0 +1,264 @@
+#include "AlphaCollider.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+
+/**
+ *  Gets twice the signed area of a polygon, positive when it is wound anti-clockwise
+ */
+static float getDoubleArea(const std::vector<Vec2>& polygon) {
+    float area = 0.f;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+        area += cross(polygon[j], polygon[i]);
+    return area;
+}
+
+
+/**
+ *  Gets the squared distance of a point from a segment
+ */
+static float getDistanceSquared(const Vec2& p, const Vec2& a, const Vec2& b) {
+    Vec2  ab = b - a;
+    float t  = lengthSquared(ab) > 0.f ? dot(p - a, ab) / lengthSquared(ab) : 0.f;
+    return lengthSquared(p - (a + std::min(std::max(t, 0.f), 1.f) * ab));
+}
+
+
+/**
+ *  Tells whether a corner turns left (anti-clockwise), with some slack for rounding
+ */
+static bool isConvex(const Vec2& prev, const Vec2& cur, const Vec2& next) {
+    Vec2 e1 = cur - prev, e2 = next - cur;
+    return cross(e1, e2) > 1e-6f * length(e1) * length(e2);
+}
+
+
+/**
+ *  Traces the outlines of the solid pixels in a rectangle of a mask, with marching squares
+ *  over the pixel centres. Outer outlines are wound anti-clockwise and holes clockwise.
+ *  @param mask - The mask, bottom row first
+ *  @param maskStride - Words per row of the mask
+ *  @param x - Left of the rectangle in pixels
+ *  @param y - Bottom of the rectangle in pixels
+ *  @param width - Width of the rectangle in pixels
+ *  @param height - Height of the rectangle in pixels
+ *  @param outlines - Output closed outlines, in pixels from the rectangle's bottom-left corner
+ */
+void traceOutlines(const uint64_t* mask, int maskStride, int x, int y, int width, int height,
+                   std::vector<std::vector<Vec2>>& outlines) {
+    // Outside the rectangle is empty, so outlines are closed at its edges
+    auto isSolid = [&](int i, int j) {
+        if (i < 0 || j < 0 || i >= width || j >= height) return false;
+        return ((mask[(size_t)(y + j) * maskStride + (x + i) / 64] >> ((x + i) % 64)) & 1) != 0;
+    };
+
+    // Crossings are at the middle of a cell's edges, keyed by twice their coordinates
+    auto makeKey = [](int dx, int dy) { return (uint64_t)(uint32_t)(dx + 2) << 32 | (uint32_t)(dy + 2); };
+    const int edgeX[4] = { 1, 2, 1, 0 },    // Bottom, right, top, left: anti-clockwise
+              edgeY[4] = { 0, 1, 2, 1 };
+
+    // Every cell's segments, solid on their left, linked end to start
+    std::unordered_map<uint64_t, uint64_t> next;
+    for (int j = -1; j < height; j++) {
+        for (int i = -1; i < width; i++) {
+            bool corners[4] = { isSolid(i, j), isSolid(i + 1, j), isSolid(i + 1, j + 1), isSolid(i, j + 1) };
+            if (corners[0] == corners[1] && corners[1] == corners[2] && corners[2] == corners[3]) continue;
+
+            // A segment comes in through an edge going solid to empty and leaves through the
+            // first edge going empty to solid clockwise of it, which keeps diagonal pixels apart
+            for (int in = 0; in < 4; in++) {
+                if (!corners[in] || corners[(in + 1) % 4]) continue;
+                int out = (in + 3) % 4;
+                while (corners[out] || !corners[(out + 1) % 4]) out = (out + 3) % 4;
+                next[makeKey(2 * i + edgeX[in], 2 * j + edgeY[in])] = makeKey(2 * i + edgeX[out], 2 * j + edgeY[out]);
+            }
+        }
+    }
+
+    // Follow the links around each outline
+    while (!next.empty()) {
+        uint64_t start = next.begin()->first, key = start;
+        std::vector<Vec2> outline;
+        do {
+            outline.push_back(Vec2(((int)(key >> 32) - 2) * 0.5f + 0.5f, ((int)(uint32_t)key - 2) * 0.5f + 0.5f));
+            std::unordered_map<uint64_t, uint64_t>::iterator link = next.find(key);
+            if (link == next.end()) break;
+            key = link->second;
+            next.erase(link);
+        } while (key != start);
+        if (outline.size() >= 3) outlines.push_back(outline);
+    }
+}
+
+
+/**
+ *  Simplifies a closed outline with Douglas-Peucker
+ *  @param outline - The outline, simplified in place
+ *  @param tolerance - How far the simplified outline may be from a dropped point
+ */
+void simplifyOutline(std::vector<Vec2>& outline, float tolerance) {
+    size_t count = outline.size();
+    if (count < 4) return;
+
+    // Split the loop at its first point and the point farthest from it
+    size_t far = 0;
+    for (size_t i = 1; i < count; i++)
+        if (lengthSquared(outline[i] - outline[0]) > lengthSquared(outline[far] - outline[0])) far = i;
+
+    std::vector<Vec2> points(outline);
+    points.push_back(outline[0]);
+    std::vector<bool> keep(count + 1, false);
+    keep[0] = keep[far] = keep[count] = true;
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    ranges.push_back(std::make_pair((size_t)0, far));
+    ranges.push_back(std::make_pair(far, count));
+    while (!ranges.empty()) {
+        size_t first = ranges.back().first, last = ranges.back().second;
+        ranges.pop_back();
+
+        size_t farthest = first;
+        float  distance = tolerance * tolerance;
+        for (size_t i = first + 1; i < last; i++) {
+            float d = getDistanceSquared(points[i], points[first], points[last]);
+            if (d > distance) {
+                distance = d;
+                farthest = i;
+            }
+        }
+        if (farthest == first) continue;
+        keep[farthest] = true;
+        ranges.push_back(std::make_pair(first, farthest));
+        ranges.push_back(std::make_pair(farthest, last));
+    }
+
+    outline.clear();
+    for (size_t i = 0; i < count; i++)
+        if (keep[i]) outline.push_back(points[i]);
+}
+
+
+/**
+ *  Splits a simple polygon into convex pieces: ear clipping, then Hertel-Mehlhorn merging of
+ *  neighbouring pieces while they stay convex and within MAX_POLYGON_VERTICES
+ *  @param polygon - The polygon, wound anti-clockwise
+ *  @param pieces - Output convex polygons, appended
+ */
+void decomposeConvex(const std::vector<Vec2>& polygon, std::vector<Shape>& pieces) {
+    // Straight corners are never ears, so drop them first
+    std::vector<int> ring;
+    for (int i = 0; i < (int)polygon.size(); i++) ring.push_back(i);
+    for (size_t i = 0; ring.size() > 3 && i < ring.size();) {
+        const Vec2& prev = polygon[ring[(i + ring.size() - 1) % ring.size()]];
+        const Vec2& cur  = polygon[ring[i]];
+        const Vec2& next = polygon[ring[(i + 1) % ring.size()]];
+        Vec2 e1 = cur - prev, e2 = next - cur;
+        if (std::fabs(cross(e1, e2)) <= 1e-6f * length(e1) * length(e2) && dot(e1, e2) >= 0.f) ring.erase(ring.begin() + i);
+        else i++;
+    }
+    if (ring.size() < 3) return;
+
+    // Ear clipping: cut off convex corners with no other vertex inside them
+    std::vector<std::vector<int>> parts;
+    while (ring.size() > 3) {
+        size_t n = ring.size(), ear = n;
+        for (size_t i = 0; i < n && ear == n; i++) {
+            int a = ring[(i + n - 1) % n], b = ring[i], c = ring[(i + 1) % n];
+            if (!isConvex(polygon[a], polygon[b], polygon[c])) continue;
+
+            bool empty = true;
+            for (size_t k = 0; k < n && empty; k++) {
+                int v = ring[k];
+                if (v == a || v == b || v == c) continue;
+                const Vec2& p = polygon[v];
+                empty = cross(polygon[b] - polygon[a], p - polygon[a]) < 0.f ||
+                        cross(polygon[c] - polygon[b], p - polygon[b]) < 0.f ||
+                        cross(polygon[a] - polygon[c], p - polygon[c]) < 0.f;
+            }
+            if (empty) ear = i;
+        }
+        if (ear == n) break;    // Self-intersecting after simplification, keep what was clipped
+
+        std::vector<int> triangle;
+        triangle.push_back(ring[(ear + n - 1) % n]);
+        triangle.push_back(ring[ear]);
+        triangle.push_back(ring[(ear + 1) % n]);
+        parts.push_back(triangle);
+        ring.erase(ring.begin() + ear);
+    }
+    if (ring.size() == 3) parts.push_back(ring);
+
+    // Merge pieces across the diagonals they share, while the result is still convex
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t a = 0; !merged && a < parts.size(); a++) {
+            for (size_t b = a + 1; !merged && b < parts.size(); b++) {
+                const std::vector<int>& A = parts[a];
+                const std::vector<int>& B = parts[b];
+                if (A.size() + B.size() - 2 > MAX_POLYGON_VERTICES) continue;
+
+                for (size_t i = 0; !merged && i < A.size(); i++) {
+                    int u = A[i], v = A[(i + 1) % A.size()];
+                    for (size_t j = 0; !merged && j < B.size(); j++) {
+                        if (B[j] != v || B[(j + 1) % B.size()] != u) continue;
+
+                        // A from v round to u, then B between u and v
+                        std::vector<int> joined;
+                        for (size_t k = 1; k <= A.size(); k++) joined.push_back(A[(i + k) % A.size()]);
+                        for (size_t k = 2; k < B.size(); k++)  joined.push_back(B[(j + k) % B.size()]);
+
+                        bool convex = true;
+                        for (size_t k = 0; k < joined.size() && convex; k++) {
+                            const Vec2& prev = polygon[joined[(k + joined.size() - 1) % joined.size()]];
+                            const Vec2& cur  = polygon[joined[k]];
+                            const Vec2& next = polygon[joined[(k + 1) % joined.size()]];
+                            convex = cross(cur - prev, next - cur) >= 0.f;
+                        }
+                        if (!convex) continue;
+
+                        parts[a] = joined;
+                        parts.erase(parts.begin() + b);
+                        merged = true;
+                    }
+                }
+            }
+        }
+    }
+
+    for (const std::vector<int>& part : parts) {
+        Vec2 points[MAX_POLYGON_VERTICES];
+        for (size_t i = 0; i < part.size(); i++) points[i] = polygon[part[i]];
+        Shape shape = makePolygon(points, (int)part.size());
+        if (shape.count >= 3) pieces.push_back(shape);
+    }
+}
+
+
+/**
+ *  Builds the convex pieces of the solid pixels in a rectangle of a mask, e.g. one frame of
+ *  a spritesheet
+ *  @param mask - The mask, bottom row first
+ *  @param maskStride - Words per row of the mask
+ *  @param x - Left of the rectangle in pixels
+ *  @param y - Bottom of the rectangle in pixels
+ *  @param width - Width of the rectangle in pixels
+ *  @param height - Height of the rectangle in pixels
+ *  @param tolerance - How far the outlines may be simplified, in pixels
+ *  @param pieces - Output convex polygons, appended, in a space where the rectangle goes from -0.5 to 0.5
+ */
+void buildAlphaCollider(const uint64_t* mask, int maskStride, int x, int y, int width, int height,
+                        float tolerance, std::vector<Shape>& pieces) {
+    std::vector<std::vector<Vec2>> outlines;
+    traceOutlines(mask, maskStride, x, y, width, height, outlines);
+
+    for (std::vector<Vec2>& outline : outlines) {
+        if (getDoubleArea(outline) <= 0.f) continue;   // A hole
+        simplifyOutline(outline, tolerance);
+        if (outline.size() < 3 || getDoubleArea(outline) < 2.f) continue;  // Under a pixel
+
+        for (Vec2& point : outline)
+            point = Vec2(point.x / width - 0.5f, point.y / height - 0.5f);
+        decomposeConvex(outline, pieces);
+    }
+}
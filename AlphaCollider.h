@@ -0,0 +1,29 @@
+#ifndef __ALPHA_COLLIDER_H
+#define __ALPHA_COLLIDER_H
+
+#include <cstdint>
+#include <vector>
+#include "Math2D.h"
+#include "Shape.h"
+
+
+/**
+ *  Collision shapes traced from a sprite's alpha, so colliders come out of the art instead
+ *  of being authored by hand.
+ *
+ *  The masks are 1 bit per pixel in 64-bit words, `maskStride` words per row, bottom row
+ *  first, as stored by TextureFile. Outlines are traced around the solid pixels with marching
+ *  squares (diagonal neighbours count as separate), simplified with Douglas-Peucker, ear
+ *  clipped into triangles and merged back into convex pieces of at most MAX_POLYGON_VERTICES.
+ *  Holes are filled: only outer outlines become pieces.
+ */
+
+void traceOutlines   (const uint64_t* mask, int maskStride, int x, int y, int width, int height,
+                      std::vector<std::vector<Vec2>>& outlines);
+void simplifyOutline (std::vector<Vec2>& outline, float tolerance);
+void decomposeConvex (const std::vector<Vec2>& polygon, std::vector<Shape>& pieces);
+
+void buildAlphaCollider(const uint64_t* mask, int maskStride, int x, int y, int width, int height,
+                        float tolerance, std::vector<Shape>& pieces);
+
+#endif // !__ALPHA_COLLIDER_H
@@ -0,0 +1,233 @@
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+AssetPack::AssetPack() {
+    mapping = nullptr;
+    size    = 0;
+#ifdef _WIN32
+    file          = INVALID_HANDLE_VALUE;
+    mappingObject = nullptr;
+#else
+    file    = -1;
+#endif
+}
+
+
+AssetPack::~AssetPack() {
+    close();
+}
+
+
+/**
+ *  Maps a pack file
+ *  @return Whether it exists and is a valid pack
+ */
+bool AssetPack::open(const char* path) {
+    close();
+
+#ifdef _WIN32
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+        size          = (size_t)fileSize.QuadPart;
+        mappingObject = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingObject) mapping = (const unsigned char*)MapViewOfFile(mappingObject, FILE_MAP_READ, 0, 0, 0);
+    }
+#else
+    file = ::open(path, O_RDONLY);
+    if (file < 0) return false;
+
+    struct stat status;
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        size = (size_t)status.st_size;
+        void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (view != MAP_FAILED) {
+            mapping = (const unsigned char*)view;
+            madvise(view, size, MADV_WILLNEED);     // Start reading ahead while the rest starts up
+        }
+    }
+#endif
+
+    if (!mapping || !validate()) {
+        std::cerr << "Not a valid asset pack: " << path << '\n';
+        close();
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ *  Unmaps the pack. Every pointer it handed out becomes invalid.
+ */
+void AssetPack::close() {
+#ifdef _WIN32
+    if (mapping) UnmapViewOfFile(mapping);
+    if (mappingObject) CloseHandle(mappingObject);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    mappingObject = nullptr;
+    file          = INVALID_HANDLE_VALUE;
+#else
+    if (mapping) munmap((void*)mapping, size);
+    if (file >= 0) ::close(file);
+    file = -1;
+#endif
+    mapping = nullptr;
+    size    = 0;
+}
+
+
+/**
+ *  Checks that the header is ours and that everything the table points to is inside the file
+ */
+bool AssetPack::validate() const {
+    if (size < sizeof(AssetPackHeader)) return false;
+
+    const AssetPackHeader& header = getHeader();
+    if (header.magic != ASSET_PACK_MAGIC || header.version != ASSET_PACK_VERSION ||
+        header.tocOffset % 8 != 0 || header.tocOffset > size ||
+        (size - header.tocOffset) / sizeof(AssetPackEntry) < header.count || header.namesOffset > size)
+        return false;
+
+    const AssetPackEntry* entries = getEntries();
+    for (uint32_t i = 0; i < header.count; i++) {
+        const AssetPackEntry& entry = entries[i];
+        if (entry.offset > size || entry.size > size - entry.offset ||
+            header.namesOffset + entry.nameOffset + entry.nameLength > size)
+            return false;
+    }
+    return true;
+}
+
+
+/**
+ *  Gets the name of an asset
+ *  @param index - Its place in the table of contents (0 to getCount() - 1), which is sorted by name
+ */
+std::string AssetPack::getName(int index) const {
+    const AssetPackEntry& entry = getEntries()[index];
+    return std::string((const char*)mapping + getHeader().namesOffset + entry.nameOffset, entry.nameLength);
+}
+
+
+/**
+ *  Finds an asset by its name
+ *  @param name - The name it was packed with
+ *  @param asset - Output pointer into the mapping and size
+ *  @return Whether the pack has it
+ */
+bool AssetPack::find(const std::string& name, Asset& asset) const {
+    if (!mapping) return false;
+
+    const AssetPackEntry* entries = getEntries();
+    const char*           names   = (const char*)mapping + getHeader().namesOffset;
+    size_t low = 0, high = getHeader().count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        const AssetPackEntry& entry = entries[middle];
+
+        // Bytewise, shorter first on a common prefix, the same order write() sorts in
+        int order = memcmp(names + entry.nameOffset, name.data(), std::min((size_t)entry.nameLength, name.size()));
+        if (order == 0) order = entry.nameLength < name.size() ? -1 : entry.nameLength > name.size() ? 1 : 0;
+
+        if (order == 0) {
+            asset.data = mapping + entry.offset;
+            asset.size = (size_t)entry.size;
+            return true;
+        }
+        if (order < 0) low  = middle + 1;
+        else           high = middle;
+    }
+    return false;
+}
+
+
+/**
+ *  Packs files into a pack file
+ *  @param path - The pack to write
+ *  @param names - What each file is found by
+ *  @param files - The files to pack, in the same order as their names
+ *  @return Whether every file could be read and the pack written
+ */
+bool AssetPack::write(const char* path, const std::vector<std::string>& names, const std::vector<std::string>& files) {
+    if (names.size() != files.size()) return false;
+
+    std::vector<size_t> order(names.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&names](size_t a, size_t b) { return names[a] < names[b]; });
+    for (size_t i = 1; i < order.size(); i++) {
+        if (names[order[i]] == names[order[i - 1]]) {
+            std::cerr << "Asset pack: " << names[order[i]] << " is in there twice" << '\n';
+            return false;
+        }
+    }
+
+    // Header, table of contents and names first, then the data
+    AssetPackHeader header;
+    header.magic       = ASSET_PACK_MAGIC;
+    header.version     = ASSET_PACK_VERSION;
+    header.count       = (uint32_t)names.size();
+    header.reserved    = 0;
+    header.tocOffset   = sizeof(AssetPackHeader);
+    header.namesOffset = header.tocOffset + names.size() * sizeof(AssetPackEntry);
+
+    std::vector<AssetPackEntry> entries(names.size());
+    std::string                 nameTable;
+    for (size_t i = 0; i < order.size(); i++) {
+        entries[i].nameOffset = (uint32_t)nameTable.size();
+        entries[i].nameLength = (uint32_t)names[order[i]].size();
+        nameTable += names[order[i]];
+    }
+
+    std::vector<unsigned char> pack(header.namesOffset + nameTable.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        FILE* file = fopen(files[order[i]].c_str(), "rb");
+        if (!file) {
+            std::cerr << "Asset pack: could not read " << files[order[i]] << '\n';
+            return false;
+        }
+        fseek(file, 0, SEEK_END);
+        long fileSize = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        size_t offset = (pack.size() + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+        pack.resize(offset + (fileSize > 0 ? (size_t)fileSize : 0));
+        bool ok = fileSize >= 0 && (fileSize == 0 || fread(&pack[offset], 1, (size_t)fileSize, file) == (size_t)fileSize);
+        fclose(file);
+        if (!ok) {
+            std::cerr << "Asset pack: could not read " << files[order[i]] << '\n';
+            return false;
+        }
+        entries[i].offset = offset;
+        entries[i].size   = (uint64_t)fileSize;
+    }
+
+    memcpy(&pack[0], &header, sizeof(header));
+    if (!entries.empty()) memcpy(&pack[header.tocOffset], &entries[0], entries.size() * sizeof(AssetPackEntry));
+    if (!nameTable.empty()) memcpy(&pack[header.namesOffset], nameTable.data(), nameTable.size());
+
+    FILE* out = fopen(path, "wb");
+    if (!out) {
+        std::cerr << "Could not write " << path << '\n';
+        return false;
+    }
+    bool ok = fwrite(&pack[0], 1, pack.size(), out) == pack.size();
+    fclose(out);
+    return ok;
+}
@@ -0,0 +1,86 @@
+#ifndef __ASSET_PACK_H
+#define __ASSET_PACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define ASSET_PACK_MAGIC        0x4B504252u     // "RBPK"
+#define ASSET_PACK_VERSION      1
+#define ASSET_PACK_ALIGNMENT    16              // Of every asset's data
+
+
+/**
+ *  The start of a pack file
+ */
+struct AssetPackHeader {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    count;                  // Entries in the table of contents
+    uint32_t    reserved;
+    uint64_t    tocOffset;              // Table of contents, from the start of the file
+    uint64_t    namesOffset;            // Names, not null-terminated
+};
+
+
+/**
+ *  An asset in the table of contents, which is sorted by name
+ */
+struct AssetPackEntry {
+    uint64_t    offset;                 // Data, from the start of the file
+    uint64_t    size;                   // Bytes
+    uint32_t    nameOffset;             // From namesOffset
+    uint32_t    nameLength;
+};
+
+
+/**
+ *  An asset's bytes, pointing into the mapping
+ */
+struct Asset {
+    const unsigned char*    data;
+    size_t                  size;
+};
+
+
+/**
+ *  A read-only archive of assets, memory-mapped as a whole.
+ *
+ *  Opening the pack is the only file operation; finding an asset is a binary search of
+ *  the table of contents and hands out a pointer into the mapping, so nothing is copied
+ *  until GL reads it. Pointers stay valid until the pack is closed. Every asset's data is
+ *  aligned to ASSET_PACK_ALIGNMENT bytes, so it can be viewed in place (e.g. TextureFile::open()).
+ *  Multi-byte fields are little-endian.
+ */
+class AssetPack {
+private:
+    const unsigned char*    mapping;
+    size_t                  size;
+#ifdef _WIN32
+    void*                   file;       // HANDLEs
+    void*                   mappingObject;
+#else
+    int                     file;
+#endif
+
+    const AssetPackHeader&  getHeader() const   { return *(const AssetPackHeader*)mapping; }
+    const AssetPackEntry*   getEntries() const  { return (const AssetPackEntry*)(mapping + getHeader().tocOffset); }
+    bool    validate() const;
+
+public:
+    AssetPack();
+    ~AssetPack();
+
+    bool    open(const char* path);
+    void    close();
+    bool    find(const std::string& name, Asset& asset) const;
+
+    bool    isOpen() const                      { return mapping != nullptr; }
+    int     getCount() const                    { return mapping ? (int)getHeader().count : 0; }
+    std::string getName(int index) const;
+
+    static bool write(const char* path, const std::vector<std::string>& names, const std::vector<std::string>& files);
+};
+
+#endif // !__ASSET_PACK_H
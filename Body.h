@@ -0,0 +1,81 @@
+#ifndef __BODY_H
+#define __BODY_H
+
+#include "Shape.h"
+
+#include <vector>
+
+
+/**
+ *  Describes a rigid body to be added to the world
+ */
+struct BodyDef {
+    Shape       shape           = makeBox(0.5f, 0.5f);
+    std::vector<Shape> compound;                // Several shapes used instead of `shape` when not empty, for one rigid body
+    float       posX            = 0.f,          // Position of the body's origin
+                posY            = 0.f,
+                angle           = 0.f,          // Angle of the body in radians (anti-clockwise)
+                velX            = 0.f,
+                velY            = 0.f,
+                angVel          = 0.f;
+    float       density         = 1.f,
+                friction        = 0.4f,
+                restitution     = 0.f;
+    bool        dynamic         = true;         // Static bodies never move
+    MassData    massData        = MassData();   // Used instead of the shape's when its mass is above 0 (e.g. from a sprite's alpha)
+    unsigned    filterCategory  = 0x0001,       // Which collision category the body belongs to
+                filterMask      = 0xFFFF;       // Which categories the body collides with
+    void*       userData        = nullptr;
+};
+
+
+/**
+ *  Hot body state, read and written by the integrator every step.
+ *  Stored as one array per component so the loops stream through contiguous floats.
+ *  Bodies move and turn around their centre of mass; their origin is found from it.
+ */
+struct BodyMotion {
+    std::vector<float>  posX,           // Centre of mass
+                        posY,
+                        angle,
+                        rotC,           // cos(angle), refreshed once per step
+                        rotS,           // sin(angle), refreshed once per step
+                        localCenterX,   // Centre of mass in the body's local space
+                        localCenterY;
+};
+
+
+/**
+ *  Hot body state, streamed through by the contact solver (and the integrator for the velocities).
+ */
+struct BodyVelocity {
+    std::vector<float>  velX,
+                        velY,
+                        angVel,
+                        invMass,
+                        invInertia;
+    std::vector<unsigned char> awake;   // Sleeping bodies are skipped by the integrator
+};
+
+
+/**
+ *  Cold body state, only touched when bodies are created, paired or queried.
+ */
+struct BodyCold {
+    std::vector<void*>      userData;
+    std::vector<unsigned>   filterCategory,
+                            filterMask;
+    std::vector<float>      friction,
+                            restitution,
+                            mass,
+                            inertia;        // Around the centre of mass
+    std::vector<int>        firstShape,     // The body's shapes in the world's list
+                            shapeCount,
+                            firstProxy,     // The body's broadphase proxies: one per shape, or one for all of them
+                            proxyCount,
+                            tree;           // Tree over the shapes of big compound bodies, -1 for the rest
+    std::vector<float>      sleepTime;      // How long the body has been (nearly) at rest
+    std::vector<int>        islandNext;     // Next body in the same sleeping island (circular), -1 when awake
+};
+
+#endif // !__BODY_H
@@ -0,0 +1,71 @@
+#include "Broadphase.h"
+
+#include <algorithm>
+
+
+/**
+ *  Adds a proxy to the broadphase
+ *  @param aabb - The bounds of the proxy
+ *  @param userData - What the proxy belongs to
+ *  @return The index of the new proxy
+ */
+int Broadphase::createProxy(const AABB& aabb, int userData) {
+    int proxy = (int)aabbs.size();
+    aabbs.push_back(aabb);
+    this->userData.push_back(userData);
+
+    SweepEntry entry = { aabb.lower.x, aabb.upper.x, aabb.lower.y, aabb.upper.y, proxy };
+    sweep.push_back(entry);
+    unsorted = true;
+    return proxy;
+}
+
+
+/**
+ *  Finds all pairs of proxies with overlapping bounds.
+ *  @param pairs - Output pairs (cleared first)
+ */
+void Broadphase::findPairs(std::vector<ProxyPair>& pairs) {
+    pairs.clear();
+
+    // Refresh the bounds in the sweep list
+    int n = (int)sweep.size();
+    for (int i = 0; i < n; i++) {
+        const AABB& box = aabbs[sweep[i].proxy];
+        sweep[i].lowerX = box.lower.x;
+        sweep[i].upperX = box.upper.x;
+        sweep[i].lowerY = box.lower.y;
+        sweep[i].upperY = box.upper.y;
+    }
+
+    // Proxies added in bulk can be in any order, so do a full sort once
+    if (unsorted) {
+        std::sort(sweep.begin(), sweep.end(), [](const SweepEntry& a, const SweepEntry& b) {
+            return a.lowerX < b.lowerX;
+        });
+        unsorted = false;
+    }
+
+    // Insertion sort, which is close to linear since the order barely changes between steps
+    for (int i = 1; i < n; i++) {
+        SweepEntry entry = sweep[i];
+        int j = i - 1;
+        while (j >= 0 && sweep[j].lowerX > entry.lowerX) {
+            sweep[j + 1] = sweep[j];
+            j--;
+        }
+        sweep[j + 1] = entry;
+    }
+
+    // Sweep along the x-axis and test the y-axis for everything that overlaps
+    for (int i = 0; i < n; i++) {
+        const SweepEntry& a = sweep[i];
+        for (int j = i + 1; j < n && sweep[j].lowerX <= a.upperX; j++) {
+            const SweepEntry& b = sweep[j];
+            if (a.upperY < b.lowerY || b.upperY < a.lowerY) continue;
+
+            ProxyPair pair = { a.proxy, b.proxy };
+            pairs.push_back(pair);
+        }
+    }
+}
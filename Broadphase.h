@@ -0,0 +1,52 @@
+#ifndef __BROADPHASE_H
+#define __BROADPHASE_H
+
+#include "Math2D.h"
+
+#include <vector>
+
+
+/**
+ *  Two proxies whose bounding boxes overlap
+ */
+struct ProxyPair {
+    int     proxyA,
+            proxyB;
+};
+
+
+/**
+ *  Sort-and-sweep broadphase.
+ *  Proxies are kept sorted along the x-axis between steps, so the insertion sort
+ *  usually only has to do a few swaps when bodies move coherently.
+ */
+class Broadphase {
+private:
+    /**
+     *  A proxy's bounds, stored in sweep order
+     */
+    struct SweepEntry {
+        float   lowerX, upperX,
+                lowerY, upperY;
+        int     proxy;
+    };
+
+    std::vector<AABB>       aabbs;      // Bounds of each proxy
+    std::vector<int>        userData;   // What each proxy belongs to (a body index)
+    std::vector<SweepEntry> sweep;      // Proxies sorted along the x-axis
+    bool                    unsorted;   // New proxies were added since the last sort
+
+public:
+    Broadphase() : unsorted(false) {}
+
+    int     createProxy(const AABB& aabb, int userData);
+    void    moveProxy(int proxy, const AABB& aabb)  { aabbs[proxy] = aabb; }
+
+    int     getUserData(int proxy)                  { return userData[proxy]; }
+    int     getProxyCount()                         { return (int)aabbs.size(); }
+    const AABB& getAABB(int proxy)                  { return aabbs[proxy]; }
+
+    void    findPairs(std::vector<ProxyPair>& pairs);
+};
+
+#endif // !__BROADPHASE_H
@@ -0,0 +1,151 @@
+#include "ColliderCache.h"
+#include "AlphaCollider.h"
+#include "AssetPack.h"
+#include "TextureFile.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+
+/**
+ *  @param tolerance - How far the traced outlines may be simplified, in pixels
+ *  @param alphaThreshold - Alpha from which a pixel is solid (cooked texture files bring their own mask)
+ */
+ColliderCache::ColliderCache(float tolerance /*= 1.f*/, int alphaThreshold /*= 128*/) {
+    this->tolerance      = tolerance;
+    this->alphaThreshold = alphaThreshold;
+    pack                 = nullptr;
+}
+
+
+/**
+ *  Loads the alpha mask of an image
+ *  @return Whether the image could be loaded
+ */
+bool ColliderCache::loadMask(const std::string& path, Image& image) {
+    Asset asset;
+    bool  packed = pack && pack->find(path, asset);
+
+    if (TextureFile::isTextureFile(path.c_str())) {
+        TextureFile file;
+        if (packed ? !file.open(asset.data, asset.size) : !file.read(path.c_str())) return false;
+        image.width  = file.getWidth();
+        image.height = file.getHeight();
+        image.mask.assign(file.getMask(), file.getMask() + (size_t)file.getMaskStride() * image.height);
+        return true;
+    }
+
+    stbi_set_flip_vertically_on_load(true);
+    int channels;
+    unsigned char* pixels = packed ? stbi_load_from_memory(asset.data, (int)asset.size, &image.width, &image.height, &channels, 4)
+                                   : stbi_load(path.c_str(), &image.width, &image.height, &channels, 4);
+    if (!pixels) return false;
+    TextureFile::buildMask(pixels, image.width, image.height, alphaThreshold, image.mask);
+    stbi_image_free(pixels);
+    return true;
+}
+
+
+/**
+ *  Gets an image's mask, loading it the first time
+ *  @return The image, null if it couldn't be loaded
+ */
+ColliderCache::Image* ColliderCache::getImage(const std::string& path) {
+    std::unordered_map<std::string, Image>::iterator it = images.find(path);
+    if (it == images.end()) {
+        Image image;
+        if (!loadMask(path, image)) {
+            std::cerr << "Collider: could not load " << path << '\n';
+            return nullptr;
+        }
+        it = images.insert(std::make_pair(path, image)).first;
+    }
+    return &it->second;
+}
+
+
+/**
+ *  Finds a frame's rectangle in pixels, the way the sprite shaders find it
+ *  @return Whether any of it is inside the image
+ */
+bool ColliderCache::findFrame(const Image& image, const floatRect& texRect, const intRect& spriteRect, int frame,
+                              FrameRect& rect) {
+    int   columns = std::max(spriteRect.x1 - spriteRect.x0, 1),
+          rows    = std::max(spriteRect.y1 - spriteRect.y0, 1),
+          step    = frame % (columns * rows);
+    float tileX   = (texRect.x1 - texRect.x0) * image.width  / columns,
+          tileY   = (texRect.y1 - texRect.y0) * image.height / rows;
+    int   x0      = (int)std::lround(texRect.x0 * image.width  + (spriteRect.x0 + step % columns) * tileX),
+          y0      = (int)std::lround(texRect.y1 * image.height - (spriteRect.y0 + step / columns + 1) * tileY),
+          x1      = std::min((int)std::lround(x0 + tileX), image.width),
+          y1      = std::min((int)std::lround(y0 + tileY), image.height);
+    rect.x      = std::max(x0, 0);
+    rect.y      = std::max(y0, 0);
+    rect.width  = x1 - rect.x;
+    rect.height = y1 - rect.y;
+    return rect.width > 0 && rect.height > 0;
+}
+
+
+/**
+ *  Gets the collision shape of a frame of a spritesheet
+ *  @param path - The image file, or its name in the pack
+ *  @param texRect - The spritesheet's rectangle in the image, as given to the sprite
+ *  @param spriteRect - The spritesheet's animation grid, as given to the sprite
+ *  @param frame - The animation step
+ *  @param sizeX - Width of the sprite, which the pieces are scaled to
+ *  @param sizeY - Height of the sprite
+ *  @param pieces - Output convex pieces, centred on the sprite (empty if the frame is transparent)
+ *  @return Whether the image could be loaded
+ */
+bool ColliderCache::get(const std::string& path, const floatRect& texRect, const intRect& spriteRect, int frame,
+                        float sizeX, float sizeY, std::vector<Shape>& pieces) {
+    pieces.clear();
+    Image* image = getImage(path);
+    if (!image) return false;
+
+    FrameRect rect;
+    if (!findFrame(*image, texRect, spriteRect, frame, rect)) return true;
+
+    std::unordered_map<uint64_t, std::vector<Shape>>::iterator cached = image->frames.find(rect.getKey());
+    if (cached == image->frames.end()) {
+        std::vector<Shape> traced;
+        buildAlphaCollider(&image->mask[0], (image->width + 63) / 64, rect.x, rect.y, rect.width, rect.height,
+                           tolerance, traced);
+        cached = image->frames.insert(std::make_pair(rect.getKey(), traced)).first;
+    }
+
+    for (const Shape& piece : cached->second) {
+        Vec2 points[MAX_POLYGON_VERTICES];
+        for (int i = 0; i < piece.count; i++)
+            points[i] = Vec2(piece.vertices[i].x * sizeX, piece.vertices[i].y * sizeY);
+        Shape scaled = makePolygon(points, piece.count);
+        if (scaled.count >= 3) pieces.push_back(scaled);
+    }
+    return true;
+}
+
+
+/**
+ *  Gets the pixel mask of a frame of a spritesheet. It stays valid until clear().
+ *  @param path - The image file, or its name in the pack
+ *  @param texRect - The spritesheet's rectangle in the image, as given to the sprite
+ *  @param spriteRect - The spritesheet's animation grid, as given to the sprite
+ *  @param frame - The animation step
+ *  @return The mask, null if the image couldn't be loaded or the frame is outside it
+ */
+const PixelMask* ColliderCache::getPixelMask(const std::string& path, const floatRect& texRect, const intRect& spriteRect,
+                                             int frame) {
+    Image*    image = getImage(path);
+    FrameRect rect;
+    if (!image || !findFrame(*image, texRect, spriteRect, frame, rect)) return nullptr;
+
+    std::unordered_map<uint64_t, PixelMask>::iterator cached = image->pixelMasks.find(rect.getKey());
+    if (cached == image->pixelMasks.end()) {
+        cached = image->pixelMasks.insert(std::make_pair(rect.getKey(), PixelMask())).first;
+        cached->second.build(&image->mask[0], (image->width + 63) / 64, rect.x, rect.y, rect.width, rect.height);
+    }
+    return &cached->second;
+}
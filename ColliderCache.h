@@ -0,0 +1,67 @@
+#ifndef __COLLIDER_CACHE_H
+#define __COLLIDER_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "PixelMask.h"
+#include "Shape.h"
+#include "Sprite.h"
+
+class AssetPack;
+
+
+/**
+ *  Collision shapes traced from the alpha of sprite images (see buildAlphaCollider()),
+ *  kept per image and per animation frame.
+ *
+ *  Each image's mask is loaded once: straight from a cooked texture file, or built from the
+ *  decoded image otherwise. Each frame's convex pieces are traced the first time they are
+ *  asked for, in a space where the frame goes from -0.5 to 0.5, and handed out scaled to the
+ *  sprite's size. Frames' pixel masks (see PixelMask) are kept the same way.
+ */
+class ColliderCache {
+private:
+    /**
+     *  One image's mask and the pieces of its frames
+     */
+    struct Image {
+        std::vector<uint64_t>   mask;
+        int                     width,
+                                height;
+        std::unordered_map<uint64_t, std::vector<Shape>> frames;   // By frame rectangle in pixels
+        std::unordered_map<uint64_t, PixelMask>          pixelMasks;
+    };
+
+    /**
+     *  Where a frame is in its image, in pixels
+     */
+    struct FrameRect {
+        int     x, y,
+                width, height;
+
+        uint64_t getKey() const { return (uint64_t)x << 48 | (uint64_t)y << 32 | (uint64_t)width << 16 | (uint64_t)height; }
+    };
+
+    std::unordered_map<std::string, Image>  images;     // By path
+    const AssetPack*                        pack;       // Looked in before the disk
+    float                                   tolerance;  // Pixels
+    int                                     alphaThreshold;
+
+    bool    loadMask(const std::string& path, Image& image);
+    Image*  getImage(const std::string& path);
+    static bool findFrame(const Image& image, const floatRect& texRect, const intRect& spriteRect, int frame,
+                          FrameRect& rect);
+
+public:
+    ColliderCache(float tolerance = 1.f, int alphaThreshold = 128);
+
+    bool    get(const std::string& path, const floatRect& texRect, const intRect& spriteRect, int frame,
+                float sizeX, float sizeY, std::vector<Shape>& pieces);
+    const PixelMask* getPixelMask(const std::string& path, const floatRect& texRect, const intRect& spriteRect, int frame);
+    void    clear()                         { images.clear(); }      // Sprites' pixel masks too
+    void    setPack(const AssetPack* pack)  { this->pack = pack; }
+};
+
+#endif // !__COLLIDER_CACHE_H
@@ -0,0 +1,353 @@
+#include "Collision.h"
+
+#include <algorithm>
+#include <cfloat>
+
+
+/**
+ *  A polygon transformed into world space
+ */
+struct WorldPolygon {
+    int     count;
+    Vec2    vertices[MAX_POLYGON_VERTICES],
+            normals[MAX_POLYGON_VERTICES];
+};
+
+
+/**
+ *  A point on the incident edge while it's being clipped
+ */
+struct ClipVertex {
+    Vec2        v;
+    unsigned    id;
+};
+
+
+/**
+ *  Transforms a polygon into world space
+ */
+static void toWorld(const Shape& shape, const Transform2D& xf, WorldPolygon& out) {
+    out.count = shape.count;
+    for (int i = 0; i < shape.count; i++) {
+        out.vertices[i] = mul(xf, shape.vertices[i]);
+        out.normals[i]  = rotate(shape.normals[i], xf.c, xf.s);
+    }
+}
+
+
+/**
+ *  Finds the edge normal of p1 along which the polygons are separated the most
+ *  @param edge - Output index of that edge
+ *  @return The separation along that edge (negative when overlapping)
+ */
+static float findMaxSeparation(int& edge, const WorldPolygon& p1, const WorldPolygon& p2) {
+    float maxSeparation = -FLT_MAX;
+    edge = 0;
+
+    for (int i = 0; i < p1.count; i++) {
+        float si = FLT_MAX;
+        for (int j = 0; j < p2.count; j++) {
+            float sij = dot(p1.normals[i], p2.vertices[j] - p1.vertices[i]);
+            if (sij < si) si = sij;
+        }
+
+        if (si > maxSeparation) {
+            maxSeparation = si;
+            edge = i;
+        }
+    }
+    return maxSeparation;
+}
+
+
+/**
+ *  Clips a segment against a line, keeping the part on the negative side.
+ *  A clipped point keeps the id of the vertex it replaces, so the id doesn't change
+ *  when a vertex hovers right on the line (like in a stack of equally wide boxes).
+ *  @return The number of points in out
+ */
+static int clipSegment(ClipVertex out[2], const ClipVertex in[2], Vec2 normal, float offset) {
+    int     n  = 0;
+    float   d0 = dot(normal, in[0].v) - offset,
+            d1 = dot(normal, in[1].v) - offset;
+
+    if (d0 <= 0.f) out[n++] = in[0];
+    if (d1 <= 0.f) out[n++] = in[1];
+
+    // The points are on different sides, so add the intersection
+    if (d0 * d1 < 0.f) {
+        float t = d0 / (d0 - d1);
+        out[n].v  = in[0].v + t * (in[1].v - in[0].v);
+        out[n].id = d0 > 0.f ? in[0].id : in[1].id;
+        n++;
+    }
+    return n;
+}
+
+
+/**
+ *  Collides two circles
+ */
+static void collideCircles(const Shape& a, const Transform2D& xfA, const Shape& b, const Transform2D& xfB, Manifold& m) {
+    Vec2    posA = mul(xfA, a.vertices[0]),
+            d    = mul(xfB, b.vertices[0]) - posA;
+    float   dist = length(d),
+            r    = a.radius + b.radius;
+
+    if (dist > r + CONTACT_MARGIN) return;
+
+    m.normal = dist > 1e-6f ? (1.f / dist) * d : Vec2(0.f, 1.f);
+    m.points[0].point      = posA + a.radius * m.normal;
+    m.points[0].separation = dist - r;
+    m.points[0].id         = 0;
+    m.count = 1;
+}
+
+
+/**
+ *  Collides a polygon (A) with a circle (B)
+ */
+static void collidePolygonCircle(const Shape& a, const Transform2D& xfA, const Shape& b, const Transform2D& xfB, Manifold& m) {
+    WorldPolygon poly;
+    toWorld(a, xfA, poly);
+    Vec2 posB = mul(xfB, b.vertices[0]);
+
+    // Find the edge closest to the centre of the circle
+    int     face          = 0;
+    float   maxSeparation = -FLT_MAX;
+    for (int i = 0; i < poly.count; i++) {
+        float s = dot(poly.normals[i], posB - poly.vertices[i]);
+        if (s > b.radius + CONTACT_MARGIN) return;
+        if (s > maxSeparation) {
+            maxSeparation = s;
+            face = i;
+        }
+    }
+
+    Vec2    v1 = poly.vertices[face],
+            v2 = poly.vertices[(face + 1) % poly.count];
+
+    // Work out which voronoi region of the edge the centre is in
+    float   u1 = dot(posB - v1, v2 - v1),
+            u2 = dot(posB - v2, v1 - v2);
+
+    if (maxSeparation > 1e-6f && (u1 <= 0.f || u2 <= 0.f)) {
+        Vec2    corner = u1 <= 0.f ? v1 : v2;
+        float   dist   = length(posB - corner);
+        if (dist > b.radius + CONTACT_MARGIN) return;
+
+        m.normal               = normalize(posB - corner);
+        m.points[0].separation = dist - b.radius;
+    } else {
+        m.normal               = poly.normals[face];
+        m.points[0].separation = maxSeparation - b.radius;
+    }
+
+    m.points[0].point = posB - b.radius * m.normal;
+    m.points[0].id    = (unsigned)face;
+    m.count = 1;
+}
+
+
+/**
+ *  Makes the contact points of a reference face by clipping the incident edge against it
+ *  @param ref - The polygon with the reference face
+ *  @param inc - The other polygon
+ *  @param edge - The reference face
+ *  @param flip - Whether the reference polygon is shape B
+ */
+static void clipFaces(const WorldPolygon* ref, const WorldPolygon* inc, int edge, bool flip, Manifold& m) {
+    // Find the incident edge, the one most anti-parallel to the reference normal
+    Vec2    normal   = ref->normals[edge];
+    int     incident = 0;
+    float   minDot   = FLT_MAX;
+    for (int i = 0; i < inc->count; i++) {
+        float d = dot(normal, inc->normals[i]);
+        if (d < minDot) {
+            minDot   = d;
+            incident = i;
+        }
+    }
+
+    int i2 = (incident + 1) % inc->count;
+    ClipVertex incidentEdge[2];
+    incidentEdge[0].v  = inc->vertices[incident];
+    incidentEdge[0].id = ((unsigned)edge << 16) | ((unsigned)incident << 8);
+    incidentEdge[1].v  = inc->vertices[i2];
+    incidentEdge[1].id = ((unsigned)edge << 16) | ((unsigned)i2 << 8);
+
+    // Clip the incident edge against the side planes of the reference edge
+    Vec2    v1      = ref->vertices[edge],
+            v2      = ref->vertices[(edge + 1) % ref->count],
+            tangent = normalize(v2 - v1);
+
+    ClipVertex clip1[2], clip2[2];
+    if (clipSegment(clip1, incidentEdge, -tangent, -dot(tangent, v1)) < 2) return;
+    if (clipSegment(clip2, clip1,         tangent,  dot(tangent, v2)) < 2) return;
+
+    // Keep the points that are below (or close to) the reference face
+    m.normal = flip ? -normal : normal;
+    m.count  = 0;
+    for (int i = 0; i < 2; i++) {
+        float separation = dot(normal, clip2[i].v - v1);
+        if (separation > CONTACT_MARGIN) continue;
+
+        ManifoldPoint& mp = m.points[m.count++];
+        mp.point      = clip2[i].v;
+        mp.separation = separation;
+        mp.id         = clip2[i].id | (flip ? 1u : 0u);
+    }
+}
+
+
+/**
+ *  Collides two convex polygons using the separating axis test and edge clipping
+ */
+static void collidePolygons(const Shape& a, const Transform2D& xfA, const Shape& b, const Transform2D& xfB, Manifold& m) {
+    WorldPolygon polyA, polyB;
+    toWorld(a, xfA, polyA);
+    toWorld(b, xfB, polyB);
+
+    int     edgeA, edgeB;
+    float   separationA = findMaxSeparation(edgeA, polyA, polyB);
+    if (separationA > CONTACT_MARGIN) return;
+    float   separationB = findMaxSeparation(edgeB, polyB, polyA);
+    if (separationB > CONTACT_MARGIN) return;
+
+    // Pick the reference face, preferring A so the choice doesn't jitter between steps
+    if (separationB > separationA + 0.1f * CONTACT_MARGIN)
+        clipFaces(&polyB, &polyA, edgeB, true, m);
+    else
+        clipFaces(&polyA, &polyB, edgeA, false, m);
+}
+
+
+/**
+ *  Tells whether an edge can push things around one of its ends: the chain stops there or
+ *  turns convexly. Where the chain goes on straight or bends inwards, the neighbouring edge
+ *  takes over, so shapes sliding across the joint don't catch on it.
+ *  @param end - 0 for the first vertex, 1 for the second
+ */
+static bool isFreeEnd(const Shape& edge, int end) {
+    Vec2 v1    = edge.vertices[0],
+         v2    = edge.vertices[1],
+         ghost = edge.vertices[2 + end],
+         joint = end == 0 ? v1 : v2;
+    if (ghost.x == joint.x && ghost.y == joint.y) return true;
+
+    Vec2 before = normalize(end == 0 ? v1 - ghost : v2 - v1),
+         after  = normalize(end == 0 ? v2 - v1    : ghost - v2);
+    return cross(before, after) > 1e-4f;
+}
+
+
+/**
+ *  Collides a one-sided edge (A) with a polygon (B)
+ */
+static void collideEdgePolygon(const Shape& a, const Transform2D& xfA, const Shape& b, const Transform2D& xfB, Manifold& m) {
+    WorldPolygon edge, poly;
+    toWorld(a, xfA, edge);
+    toWorld(b, xfB, poly);
+    Vec2 v1 = edge.vertices[0], normal = edge.normals[0];
+
+    // Only the edge's front normal and the polygon's normals are tried as separating axes.
+    // Polygons all the way behind the edge pass through it; ones that sank partly in (e.g.
+    // falling fast) are pushed back out.
+    float separationA = FLT_MAX, front = -FLT_MAX;
+    for (int i = 0; i < poly.count; i++) {
+        float s = dot(normal, poly.vertices[i] - v1);
+        separationA = std::min(separationA, s);
+        front       = std::max(front, s);
+    }
+    if (separationA > CONTACT_MARGIN || front < 0.f) return;
+    int   edgeB;
+    float separationB = findMaxSeparation(edgeB, poly, edge);
+    if (separationB > CONTACT_MARGIN) return;
+
+    // A polygon face only pushes around a free end of the edge (the one deeper in the face);
+    // at joints the edge's own normal is used, which is what stops ghost collisions at seams
+    bool useB = separationB > separationA + 0.1f * CONTACT_MARGIN;
+    if (useB && dot(-poly.normals[edgeB], normal) < 0.999f) {
+        int end = dot(poly.normals[edgeB], edge.vertices[0]) < dot(poly.normals[edgeB], edge.vertices[1]) ? 0 : 1;
+        useB = isFreeEnd(a, end);
+    }
+    if (useB) clipFaces(&poly, &edge, edgeB, true, m);
+    else      clipFaces(&edge, &poly, 0, false, m);
+}
+
+
+/**
+ *  Collides a one-sided edge (A) with a circle (B)
+ */
+static void collideEdgeCircle(const Shape& a, const Transform2D& xfA, const Shape& b, const Transform2D& xfB, Manifold& m) {
+    Vec2    v1     = mul(xfA, a.vertices[0]),
+            v2     = mul(xfA, a.vertices[1]),
+            normal = rotate(a.normals[0], xfA.c, xfA.s),
+            posB   = mul(xfB, b.vertices[0]);
+
+    // Circles all the way behind the edge pass through it, like polygons
+    float s = dot(normal, posB - v1);
+    if (s < -b.radius || s > b.radius + CONTACT_MARGIN) return;
+
+    // Past an end, a circle in front is pushed around it if it's free, and left to the neighbour otherwise
+    Vec2  e = v2 - v1;
+    float u = dot(posB - v1, e);
+    if (u <= 0.f || u >= dot(e, e)) {
+        int end = u <= 0.f ? 0 : 1;
+        if (s < 0.f || !isFreeEnd(a, end)) return;
+
+        Vec2  corner = end == 0 ? v1 : v2;
+        float dist   = length(posB - corner);
+        if (dist > b.radius + CONTACT_MARGIN) return;
+
+        m.normal               = dist > 1e-6f ? (1.f / dist) * (posB - corner) : normal;
+        m.points[0].separation = dist - b.radius;
+        m.points[0].id         = 1u + (unsigned)end;
+    } else {
+        m.normal               = normal;
+        m.points[0].separation = s - b.radius;
+        m.points[0].id         = 0;
+    }
+
+    m.points[0].point = posB - b.radius * m.normal;
+    m.count = 1;
+}
+
+
+/**
+ *  Generates the contact manifold between two shapes
+ *  @param a - The first shape
+ *  @param xfA - The transform of the first shape's body
+ *  @param b - The second shape
+ *  @param xfB - The transform of the second shape's body
+ *  @param manifold - Output contact points, count is 0 when not touching
+ */
+void collide(const Shape& a, const Transform2D& xfA,
+             const Shape& b, const Transform2D& xfB,
+             Manifold& manifold) {
+    manifold.count = 0;
+
+    // Degenerate polygons (see makePolygon()) have no faces to collide with
+    if ((a.type == SHAPE_POLYGON && a.count < 3) || (b.type == SHAPE_POLYGON && b.count < 3)) return;
+
+    // Edges are static level geometry, so they don't collide with each other
+    if (a.type == SHAPE_EDGE || b.type == SHAPE_EDGE) {
+        bool               flip    = b.type == SHAPE_EDGE;
+        const Shape&       edge    = flip ? b : a;
+        const Shape&       other   = flip ? a : b;
+        const Transform2D& xfEdge  = flip ? xfB : xfA;
+        const Transform2D& xfOther = flip ? xfA : xfB;
+        if (other.type == SHAPE_POLYGON)     collideEdgePolygon(edge, xfEdge, other, xfOther, manifold);
+        else if (other.type == SHAPE_CIRCLE) collideEdgeCircle (edge, xfEdge, other, xfOther, manifold);
+        if (flip) manifold.normal = -manifold.normal;
+    } else if (a.type == SHAPE_CIRCLE && b.type == SHAPE_CIRCLE) {
+        collideCircles(a, xfA, b, xfB, manifold);
+    } else if (a.type == SHAPE_POLYGON && b.type == SHAPE_CIRCLE) {
+        collidePolygonCircle(a, xfA, b, xfB, manifold);
+    } else if (a.type == SHAPE_CIRCLE && b.type == SHAPE_POLYGON) {
+        collidePolygonCircle(b, xfB, a, xfA, manifold);
+        manifold.normal = -manifold.normal;
+    } else {
+        collidePolygons(a, xfA, b, xfB, manifold);
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef __COLLISION_H
+#define __COLLISION_H
+
+#include "Math2D.h"
+#include "Shape.h"
+#include "Transform2D.h"
+
+#define CONTACT_MARGIN 0.005f   // Contacts closer than this are kept, so resting contacts don't flicker
+
+
+/**
+ *  A single contact point between two shapes
+ */
+struct ManifoldPoint {
+    Vec2        point;          // World-space contact point
+    float       separation;     // Negative when the shapes are penetrating
+    unsigned    id;             // Feature key, used to match points between steps
+};
+
+
+/**
+ *  The contact points between two shapes.
+ *  The normal points from shape A towards shape B.
+ */
+struct Manifold {
+    Vec2            normal;
+    ManifoldPoint   points[2];
+    int             count;
+};
+
+void collide(const Shape& a, const Transform2D& xfA,
+             const Shape& b, const Transform2D& xfB,
+             Manifold& manifold);
+
+#endif // !__COLLISION_H
@@ -0,0 +1,138 @@
+#include "ContactSolver.h"
+
+#include <algorithm>
+
+
+/**
+ *  Starts a new step. The current constraints become the warm starting data.
+ */
+void ContactSolver::begin() {
+    previous.swap(constraints);
+    constraints.clear();
+
+    std::sort(previous.begin(), previous.end(), [](const ContactConstraint& a, const ContactConstraint& b) {
+        return a.key < b.key;
+    });
+}
+
+
+/**
+ *  Computes the effective masses and velocity targets of the constraints,
+ *  and applies the impulses from the previous step (warm starting)
+ *  @param bodies - The velocity state of the bodies
+ *  @param dt - The timestep
+ */
+void ContactSolver::prepare(BodyVelocity& bodies, float dt) {
+    float invDt = dt > 0.f ? 1.f / dt : 0.f;
+
+    for (ContactConstraint& c : constraints) {
+        int     a  = c.bodyA,
+                b  = c.bodyB;
+        float   mA = bodies.invMass[a],     iA = bodies.invInertia[a],
+                mB = bodies.invMass[b],     iB = bodies.invInertia[b];
+        Vec2    vA(bodies.velX[a], bodies.velY[a]),
+                vB(bodies.velX[b], bodies.velY[b]),
+                tangent = cross(c.normal, 1.f);
+        float   wA = bodies.angVel[a],
+                wB = bodies.angVel[b];
+
+        // Look for the same pair in the previous step
+        auto match = std::lower_bound(previous.begin(), previous.end(), c.key,
+            [](const ContactConstraint& p, unsigned long long key) { return p.key < key; });
+        bool warm = match != previous.end() && match->key == c.key;
+
+        for (int i = 0; i < c.count; i++) {
+            ContactPoint& cp = c.points[i];
+
+            // Effective masses along the normal and the tangent
+            float   rnA = cross(cp.rA, c.normal), rnB = cross(cp.rB, c.normal),
+                    rtA = cross(cp.rA, tangent),  rtB = cross(cp.rB, tangent),
+                    kNormal  = mA + mB + iA * rnA * rnA + iB * rnB * rnB,
+                    kTangent = mA + mB + iA * rtA * rtA + iB * rtB * rtB;
+            cp.normalMass  = kNormal  > 0.f ? 1.f / kNormal  : 0.f;
+            cp.tangentMass = kTangent > 0.f ? 1.f / kTangent : 0.f;
+
+            // Velocity target: close gaps, push out penetration, and bounce
+            if (cp.separation > 0.f)
+                cp.bias = -cp.separation * invDt;
+            else
+                cp.bias = baumgarte * invDt * std::max(0.f, -cp.separation - linearSlop);
+
+            Vec2    dv = vB + cross(wB, cp.rB) - vA - cross(wA, cp.rA);
+            float   vn = dot(dv, c.normal);
+            if (vn < -1.f)
+                cp.bias = std::max(cp.bias, -c.restitution * vn);
+
+            // Reuse the impulse of the matching point from the previous step
+            cp.normalImpulse = cp.tangentImpulse = 0.f;
+            if (warm) {
+                for (int j = 0; j < match->count; j++) {
+                    if (match->points[j].id != cp.id) continue;
+                    cp.normalImpulse  = match->points[j].normalImpulse;
+                    cp.tangentImpulse = match->points[j].tangentImpulse;
+                    break;
+                }
+            }
+
+            Vec2 P = cp.normalImpulse * c.normal + cp.tangentImpulse * tangent;
+            vA -= mA * P;   wA -= iA * cross(cp.rA, P);
+            vB += mB * P;   wB += iB * cross(cp.rB, P);
+        }
+
+        bodies.velX[a] = vA.x; bodies.velY[a] = vA.y; bodies.angVel[a] = wA;
+        bodies.velX[b] = vB.x; bodies.velY[b] = vB.y; bodies.angVel[b] = wB;
+    }
+}
+
+
+/**
+ *  Runs one iteration of the solver over all constraints
+ *  @param bodies - The velocity state of the bodies
+ */
+void ContactSolver::solve(BodyVelocity& bodies) {
+    for (ContactConstraint& c : constraints) {
+        int     a  = c.bodyA,
+                b  = c.bodyB;
+        float   mA = bodies.invMass[a],     iA = bodies.invInertia[a],
+                mB = bodies.invMass[b],     iB = bodies.invInertia[b];
+        Vec2    vA(bodies.velX[a], bodies.velY[a]),
+                vB(bodies.velX[b], bodies.velY[b]),
+                tangent = cross(c.normal, 1.f);
+        float   wA = bodies.angVel[a],
+                wB = bodies.angVel[b];
+
+        // Friction first, since non-penetration is more important
+        for (int i = 0; i < c.count; i++) {
+            ContactPoint& cp = c.points[i];
+
+            Vec2    dv       = vB + cross(wB, cp.rB) - vA - cross(wA, cp.rA);
+            float   lambda   = -cp.tangentMass * dot(dv, tangent),
+                    maxF     = c.friction * cp.normalImpulse,
+                    impulse  = std::max(-maxF, std::min(cp.tangentImpulse + lambda, maxF));
+            lambda = impulse - cp.tangentImpulse;
+            cp.tangentImpulse = impulse;
+
+            Vec2 P = lambda * tangent;
+            vA -= mA * P;   wA -= iA * cross(cp.rA, P);
+            vB += mB * P;   wB += iB * cross(cp.rB, P);
+        }
+
+        // Non-penetration
+        for (int i = 0; i < c.count; i++) {
+            ContactPoint& cp = c.points[i];
+
+            Vec2    dv      = vB + cross(wB, cp.rB) - vA - cross(wA, cp.rA);
+            float   lambda  = -cp.normalMass * (dot(dv, c.normal) - cp.bias),
+                    impulse = std::max(cp.normalImpulse + lambda, 0.f);
+            lambda = impulse - cp.normalImpulse;
+            cp.normalImpulse = impulse;
+
+            Vec2 P = lambda * c.normal;
+            vA -= mA * P;   wA -= iA * cross(cp.rA, P);
+            vB += mB * P;   wB += iB * cross(cp.rB, P);
+        }
+
+        bodies.velX[a] = vA.x; bodies.velY[a] = vA.y; bodies.angVel[a] = wA;
+        bodies.velX[b] = vB.x; bodies.velY[b] = vB.y; bodies.angVel[b] = wB;
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef __CONTACT_SOLVER_H
+#define __CONTACT_SOLVER_H
+
+#include "Math2D.h"
+#include "Body.h"
+
+#include <vector>
+
+
+/**
+ *  A contact point prepared for the solver
+ */
+struct ContactPoint {
+    Vec2        rA, rB;             // Contact point relative to the bodies' centres of mass
+    float       separation,
+                normalImpulse,      // Accumulated impulses, kept between steps for warm starting
+                tangentImpulse,
+                normalMass,
+                tangentMass,
+                bias;               // Target normal velocity
+    unsigned    id;
+};
+
+
+/**
+ *  The contact between two bodies
+ */
+struct ContactConstraint {
+    unsigned long long  key;        // Identifies the pair of shapes between steps
+    int                 bodyA,
+                        bodyB;
+    Vec2                normal;     // Points from A to B
+    float               friction,
+                        restitution;
+    int                 count;
+    ContactPoint        points[2];
+};
+
+
+/**
+ *  Sequential impulse solver for contact constraints.
+ *  Only touches the velocity part of the body state.
+ */
+class ContactSolver {
+private:
+    std::vector<ContactConstraint>  constraints,
+                                    previous;       // Last step's constraints, sorted by key
+
+public:
+    float   baumgarte  = 0.2f,      // How much of the penetration is corrected per step
+            linearSlop = 0.005f;    // Penetration that is allowed, to keep contacts stable
+
+    void                begin();
+    ContactConstraint&  add()           { constraints.emplace_back(); return constraints.back(); }
+    int                 getCount()      { return (int)constraints.size(); }
+    const ContactConstraint& getConstraint(int i) { return constraints[i]; }
+
+    void    prepare(BodyVelocity& bodies, float dt);
+    void    solve(BodyVelocity& bodies);
+};
+
+#endif // !__CONTACT_SOLVER_H
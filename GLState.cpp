@@ -0,0 +1,201 @@
+#include "GLState.h"
+
+#define GL_STATE_UNKNOWN 0xFFFFFFFFu    // Not known yet, so the next call always goes through
+
+
+/**
+ *  A capability whose enabled state is tracked
+ */
+struct Capability {
+    GLenum  capability;
+    GLuint  enabled;                    // 0, 1 or GL_STATE_UNKNOWN
+};
+
+
+static GLuint       program          = GL_STATE_UNKNOWN,
+                    activeUnit       = GL_STATE_UNKNOWN,    // Index, not GL_TEXTUREi
+                    vertexArray      = GL_STATE_UNKNOWN,
+                    arrayBuffer      = GL_STATE_UNKNOWN,
+                    unpackBuffer     = GL_STATE_UNKNOWN,
+                    blendSource      = GL_STATE_UNKNOWN,
+                    blendDestination = GL_STATE_UNKNOWN;
+static Capability   capabilities[] = {
+    { GL_BLEND,         GL_STATE_UNKNOWN },
+    { GL_MULTISAMPLE,   GL_STATE_UNKNOWN },
+    { GL_DEPTH_TEST,    GL_STATE_UNKNOWN },
+    { GL_SCISSOR_TEST,  GL_STATE_UNKNOWN },
+    { GL_CULL_FACE,     GL_STATE_UNKNOWN },
+};
+static uint64_t     calls   = 0,        // Calls made through the tracker
+                    elided  = 0;        // Of which skipped
+
+
+/**
+ *  The GL_TEXTURE_2D binding of each texture unit
+ */
+static struct TextureBindings {
+    GLuint  units[GL_STATE_TEXTURE_UNITS];
+    TextureBindings() { for (GLuint& unit : units) unit = GL_STATE_UNKNOWN; }
+} textures;
+
+
+/**
+ *  Counts a call and tells whether it has to reach GL
+ *  @param current - The tracked value, updated to the new one
+ *  @param value - The new value
+ */
+static bool changes(GLuint& current, GLuint value) {
+    calls++;
+    if (current == value) {
+        elided++;
+        return false;
+    }
+    current = value;
+    return true;
+}
+
+
+/**
+ *  Gets the tracked state of a capability, or null if it isn't tracked
+ */
+static Capability* findCapability(GLenum capability) {
+    for (Capability& c : capabilities) {
+        if (c.capability == capability) return &c;
+    }
+    return nullptr;
+}
+
+
+void GLState::useProgram(GLuint program) {
+    if (changes(::program, program)) glUseProgram(program);
+}
+
+
+void GLState::activeTexture(GLenum unit) {
+    if (changes(activeUnit, unit - GL_TEXTURE0)) glActiveTexture(unit);
+}
+
+
+/**
+ *  Binds a texture to the active unit. Only GL_TEXTURE_2D bindings are tracked.
+ */
+void GLState::bindTexture(GLenum target, GLuint texture) {
+    if (target != GL_TEXTURE_2D || activeUnit >= GL_STATE_TEXTURE_UNITS) {
+        calls++;
+        glBindTexture(target, texture);
+        return;
+    }
+    if (changes(textures.units[activeUnit], texture)) glBindTexture(target, texture);
+}
+
+
+void GLState::bindVertexArray(GLuint vao) {
+    if (changes(vertexArray, vao)) glBindVertexArray(vao);
+}
+
+
+/**
+ *  Binds a buffer. Array and pixel unpack buffers are tracked, other targets are passed through.
+ */
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+    GLuint* current = target == GL_ARRAY_BUFFER        ? &arrayBuffer
+                    : target == GL_PIXEL_UNPACK_BUFFER ? &unpackBuffer
+                    : nullptr;
+    if (!current) {
+        calls++;
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (changes(*current, buffer)) glBindBuffer(target, buffer);
+}
+
+
+void GLState::enable(GLenum capability) {
+    Capability* c = findCapability(capability);
+    if (!c) {
+        calls++;
+        glEnable(capability);
+    }
+    else if (changes(c->enabled, 1)) glEnable(capability);
+}
+
+
+void GLState::disable(GLenum capability) {
+    Capability* c = findCapability(capability);
+    if (!c) {
+        calls++;
+        glDisable(capability);
+    }
+    else if (changes(c->enabled, 0)) glDisable(capability);
+}
+
+
+void GLState::blendFunc(GLenum source, GLenum destination) {
+    calls++;
+    if (blendSource == source && blendDestination == destination) {
+        elided++;
+        return;
+    }
+    blendSource      = source;
+    blendDestination = destination;
+    glBlendFunc(source, destination);
+}
+
+
+/**
+ *  Deleting a bound object unbinds it, and GL may hand its name out again
+ */
+void GLState::deleteProgram(GLuint program) {
+    if (::program == program) ::program = GL_STATE_UNKNOWN;
+    glDeleteProgram(program);
+}
+
+
+void GLState::deleteTextures(GLsizei count, const GLuint* textures) {
+    for (GLsizei i = 0; i < count; i++) {
+        for (GLuint& bound : ::textures.units) {
+            if (bound == textures[i]) bound = 0;
+        }
+    }
+    glDeleteTextures(count, textures);
+}
+
+
+void GLState::deleteVertexArrays(GLsizei count, const GLuint* vaos) {
+    for (GLsizei i = 0; i < count; i++) {
+        if (vertexArray == vaos[i]) vertexArray = 0;
+    }
+    glDeleteVertexArrays(count, vaos);
+}
+
+
+void GLState::deleteBuffers(GLsizei count, const GLuint* buffers) {
+    for (GLsizei i = 0; i < count; i++) {
+        if (arrayBuffer  == buffers[i]) arrayBuffer  = 0;
+        if (unpackBuffer == buffers[i]) unpackBuffer = 0;
+    }
+    glDeleteBuffers(count, buffers);
+}
+
+
+/**
+ *  Forgets the tracked state, so the next call of each kind goes through
+ */
+void GLState::invalidate() {
+    program = activeUnit = vertexArray = arrayBuffer = unpackBuffer = GL_STATE_UNKNOWN;
+    blendSource = blendDestination = GL_STATE_UNKNOWN;
+    for (GLuint& texture : textures.units)
+        texture = GL_STATE_UNKNOWN;
+    for (Capability& c : capabilities)
+        c.enabled = GL_STATE_UNKNOWN;
+}
+
+
+uint64_t GLState::getCallCount()    { return calls; }
+uint64_t GLState::getElidedCount()  { return elided; }
+
+
+void GLState::resetCounters() {
+    calls  = 0;
+    elided = 0;
+}
@@ -0,0 +1,42 @@
+#ifndef __GL_STATE_H
+#define __GL_STATE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+
+#define GL_STATE_TEXTURE_UNITS 16       // Texture units whose bindings are tracked
+
+
+/**
+ *  Tracks the GL state the renderer changes, skipping calls that wouldn't change anything.
+ *
+ *  Everything that binds, enables or deletes these objects must go through here, or the
+ *  tracked state drifts from the real one; call invalidate() after code that doesn't
+ *  (e.g. a third party library). Only one GL context is assumed.
+ *  Element array buffer bindings are part of the vertex array, so they are passed through.
+ */
+class GLState {
+public:
+    static void useProgram(GLuint program);
+    static void activeTexture(GLenum unit);
+    static void bindTexture(GLenum target, GLuint texture);
+    static void bindVertexArray(GLuint vao);
+    static void bindBuffer(GLenum target, GLuint buffer);
+    static void enable(GLenum capability);
+    static void disable(GLenum capability);
+    static void blendFunc(GLenum source, GLenum destination);
+
+    static void deleteProgram(GLuint program);
+    static void deleteTextures(GLsizei count, const GLuint* textures);
+    static void deleteVertexArrays(GLsizei count, const GLuint* vaos);
+    static void deleteBuffers(GLsizei count, const GLuint* buffers);
+
+    static void invalidate();
+
+    static uint64_t getCallCount();
+    static uint64_t getElidedCount();
+    static void     resetCounters();
+};
+
+#endif // !__GL_STATE_H
@@ -0,0 +1,90 @@
+#include "JointSolver.h"
+
+
+/**
+ *  Adds a revolute joint
+ *  @param bodyA - The first body
+ *  @param bodyB - The second body
+ *  @param localAnchorA - The pivot in body A's local space, from its centre of mass
+ *  @param localAnchorB - The pivot in body B's local space, from its centre of mass
+ *  @return The index of the joint
+ */
+int JointSolver::add(int bodyA, int bodyB, Vec2 localAnchorA, Vec2 localAnchorB) {
+    RevoluteJoint joint;
+    joint.bodyA        = bodyA;
+    joint.bodyB        = bodyB;
+    joint.localAnchorA = localAnchorA;
+    joint.localAnchorB = localAnchorB;
+    joints.push_back(joint);
+    return (int)joints.size() - 1;
+}
+
+
+/**
+ *  Computes the effective masses and drift correction of the joints, and warm starts them
+ *  @param motion - The positions and cached rotations of the bodies
+ *  @param bodies - The velocity state of the bodies
+ *  @param dt - The timestep
+ */
+void JointSolver::prepare(const BodyMotion& motion, BodyVelocity& bodies, float dt) {
+    float invDt = dt > 0.f ? 1.f / dt : 0.f;
+
+    for (RevoluteJoint& j : joints) {
+        int     a  = j.bodyA,
+                b  = j.bodyB;
+        float   mA = bodies.invMass[a],     iA = bodies.invInertia[a],
+                mB = bodies.invMass[b],     iB = bodies.invInertia[b];
+
+        j.rA = rotate(j.localAnchorA, motion.rotC[a], motion.rotS[a]);
+        j.rB = rotate(j.localAnchorB, motion.rotC[b], motion.rotS[b]);
+
+        // Effective mass matrix, K = [k11 k12; k12 k22], and its inverse
+        float   k11 = mA + mB + iA * j.rA.y * j.rA.y + iB * j.rB.y * j.rB.y,
+                k12 = -iA * j.rA.x * j.rA.y - iB * j.rB.x * j.rB.y,
+                k22 = mA + mB + iA * j.rA.x * j.rA.x + iB * j.rB.x * j.rB.x,
+                det = k11 * k22 - k12 * k12;
+        det = det != 0.f ? 1.f / det : 0.f;
+        j.k11 =  det * k22;
+        j.k12 = -det * k12;
+        j.k22 =  det * k11;
+
+        // Pull the anchors back together
+        Vec2 C = Vec2(motion.posX[b], motion.posY[b]) + j.rB - Vec2(motion.posX[a], motion.posY[a]) - j.rA;
+        j.bias = -baumgarte * invDt * C;
+
+        // Warm start
+        bodies.velX[a] -= mA * j.impulse.x;     bodies.velY[a] -= mA * j.impulse.y;
+        bodies.velX[b] += mB * j.impulse.x;     bodies.velY[b] += mB * j.impulse.y;
+        bodies.angVel[a] -= iA * cross(j.rA, j.impulse);
+        bodies.angVel[b] += iB * cross(j.rB, j.impulse);
+    }
+}
+
+
+/**
+ *  Runs one iteration of the solver over all joints
+ *  @param bodies - The velocity state of the bodies
+ */
+void JointSolver::solve(BodyVelocity& bodies) {
+    for (RevoluteJoint& j : joints) {
+        int     a  = j.bodyA,
+                b  = j.bodyB;
+        float   mA = bodies.invMass[a],     iA = bodies.invInertia[a],
+                mB = bodies.invMass[b],     iB = bodies.invInertia[b];
+        Vec2    vA(bodies.velX[a], bodies.velY[a]),
+                vB(bodies.velX[b], bodies.velY[b]);
+        float   wA = bodies.angVel[a],
+                wB = bodies.angVel[b];
+
+        Vec2 Cdot = vB + cross(wB, j.rB) - vA - cross(wA, j.rA),
+             rhs  = j.bias - Cdot,
+             P(j.k11 * rhs.x + j.k12 * rhs.y, j.k12 * rhs.x + j.k22 * rhs.y);
+        j.impulse += P;
+
+        vA -= mA * P;   wA -= iA * cross(j.rA, P);
+        vB += mB * P;   wB += iB * cross(j.rB, P);
+
+        bodies.velX[a] = vA.x; bodies.velY[a] = vA.y; bodies.angVel[a] = wA;
+        bodies.velX[b] = vB.x; bodies.velY[b] = vB.y; bodies.angVel[b] = wB;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef __JOINT_SOLVER_H
+#define __JOINT_SOLVER_H
+
+#include "Math2D.h"
+#include "Body.h"
+
+#include <vector>
+
+
+/**
+ *  A revolute joint, pinning a point on body A to a point on body B
+ */
+struct RevoluteJoint {
+    int     bodyA,
+            bodyB;
+    Vec2    localAnchorA,       // Anchor in body A's local space, from its centre of mass
+            localAnchorB;       // Anchor in body B's local space, from its centre of mass
+
+    // Solver data
+    Vec2    rA, rB,             // Anchors relative to the bodies' centres of mass, in world space
+            bias,               // Target relative velocity at the anchor
+            impulse;            // Accumulated impulse, kept between steps for warm starting
+    float   k11, k12, k22;      // Inverse of the 2x2 effective mass matrix
+};
+
+
+/**
+ *  Sequential impulse solver for joints
+ */
+class JointSolver {
+private:
+    std::vector<RevoluteJoint>  joints;
+
+public:
+    float   baumgarte = 0.2f;   // How much of the joint drift is corrected per step
+
+    int             add(int bodyA, int bodyB, Vec2 localAnchorA, Vec2 localAnchorB);
+    int             getCount()              { return (int)joints.size(); }
+    RevoluteJoint&  getJoint(int joint)     { return joints[joint]; }
+
+    void    prepare(const BodyMotion& motion, BodyVelocity& bodies, float dt);
+    void    solve(BodyVelocity& bodies);
+};
+
+#endif // !__JOINT_SOLVER_H
@@ -0,0 +1,74 @@
+#ifndef __MATH2D_H
+#define __MATH2D_H
+
+#include <cmath>
+
+// SSE2 is available on every x64 target, and on x86 when it's enabled
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RBPHYS_SSE2
+#endif
+
+
+/**
+ *  A simple 2D vector used by the physics code
+ */
+struct Vec2 {
+    float   x, y;
+
+    Vec2() : x(0.f), y(0.f) {}
+    Vec2(float x, float y) : x(x), y(y) {}
+
+    Vec2    operator-() const           { return Vec2(-x, -y); }
+    void    operator+=(const Vec2& v)   { x += v.x; y += v.y; }
+    void    operator-=(const Vec2& v)   { x -= v.x; y -= v.y; }
+    void    operator*=(float s)         { x *= s; y *= s; }
+};
+
+
+/**
+ *  An axis-aligned bounding box
+ */
+struct AABB {
+    Vec2    lower,
+            upper;
+};
+
+
+inline Vec2  operator+(const Vec2& a, const Vec2& b)   { return Vec2(a.x + b.x, a.y + b.y); }
+inline Vec2  operator-(const Vec2& a, const Vec2& b)   { return Vec2(a.x - b.x, a.y - b.y); }
+inline Vec2  operator*(float s, const Vec2& v)         { return Vec2(s * v.x, s * v.y); }
+inline Vec2  operator*(const Vec2& v, float s)         { return Vec2(s * v.x, s * v.y); }
+
+inline float dot(const Vec2& a, const Vec2& b)         { return a.x * b.x + a.y * b.y; }
+inline float cross(const Vec2& a, const Vec2& b)       { return a.x * b.y - a.y * b.x; }
+inline Vec2  cross(float s, const Vec2& v)             { return Vec2(-s * v.y, s * v.x); }
+inline Vec2  cross(const Vec2& v, float s)             { return Vec2(s * v.y, -s * v.x); }
+inline float lengthSquared(const Vec2& v)              { return v.x * v.x + v.y * v.y; }
+inline float length(const Vec2& v)                     { return std::sqrt(v.x * v.x + v.y * v.y); }
+
+inline Vec2  rotate(const Vec2& v, float c, float s)     { return Vec2(c * v.x - s * v.y, s * v.x + c * v.y); }
+inline Vec2  invRotate(const Vec2& v, float c, float s)  { return Vec2(c * v.x + s * v.y, -s * v.x + c * v.y); }
+
+inline Vec2  minVec(const Vec2& a, const Vec2& b)      { return Vec2(a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y); }
+inline Vec2  maxVec(const Vec2& a, const Vec2& b)      { return Vec2(a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y); }
+
+
+/**
+ *  Returns a unit vector in the direction of v (or v itself if it is too short)
+ */
+inline Vec2 normalize(const Vec2& v) {
+    float len = length(v);
+    if (len < 1e-9f) return v;
+    return Vec2(v.x / len, v.y / len);
+}
+
+
+/**
+ *  Checks whether two AABBs overlap
+ */
+inline bool overlaps(const AABB& a, const AABB& b) {
+    return !(a.upper.x < b.lower.x || b.upper.x < a.lower.x ||
+             a.upper.y < b.lower.y || b.upper.y < a.lower.y);
+}
+
+#endif // !__MATH2D_H
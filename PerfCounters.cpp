@@ -0,0 +1,162 @@
+#include "PerfCounters.h"
+
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+PerfCounters::PerfCounters() : opened(0) {
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        fds[i]   = -1;
+        slots[i] = -1;
+    }
+    reset();
+}
+
+
+PerfCounters::~PerfCounters() {
+    close();
+}
+
+
+#ifdef __linux__
+/**
+ *  Opens one hardware event counting the calling thread in user space
+ *  @param config - The PERF_COUNT_HW_* event
+ *  @param group - The group leader, or -1 to open a new group
+ *  @return The file descriptor, or -1 on failure
+ */
+static int openEvent(uint64_t config, int group) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.config         = config;
+    attr.disabled       = group < 0 ? 1 : 0;   // The leader starts the whole group
+    attr.exclude_kernel = 1;                    // Allowed with perf_event_paranoid <= 2
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+#endif
+
+
+/**
+ *  Opens the counters for the calling thread. Events the CPU doesn't support are skipped.
+ *  @return Whether at least the cycle counter could be opened
+ */
+bool PerfCounters::open() {
+    close();
+#ifdef __linux__
+    static const uint64_t configs[PERF_EVENT_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,             // Last level cache misses
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        fds[i] = openEvent(configs[i], fds[PERF_CYCLES]);
+        if (fds[i] < 0) {
+            if (i == PERF_CYCLES) return false;
+            continue;
+        }
+        slots[i] = opened++;
+    }
+
+    ioctl(fds[PERF_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds[PERF_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+/**
+ *  Closes the counters, the totals are kept
+ */
+void PerfCounters::close() {
+#ifdef __linux__
+    for (int i = PERF_EVENT_COUNT - 1; i >= 0; i--) {
+        if (fds[i] >= 0) ::close(fds[i]);
+    }
+#endif
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        fds[i]   = -1;
+        slots[i] = -1;
+    }
+    opened = 0;
+}
+
+
+/**
+ *  Clears the totals of all phases
+ */
+void PerfCounters::reset() {
+    memset(start,   0, sizeof(start));
+    memset(totals,  0, sizeof(totals));
+    memset(samples, 0, sizeof(samples));
+}
+
+
+/**
+ *  Reads the whole group at once, scaled up if the kernel had to multiplex the counters
+ *  @param values - Output count of each event (0 for unavailable events)
+ *  @return Whether the counters could be read
+ */
+bool PerfCounters::read(uint64_t values[PERF_EVENT_COUNT]) {
+#ifdef __linux__
+    // Layout of a PERF_FORMAT_GROUP read: nr, time_enabled, time_running, values[nr]
+    uint64_t buffer[3 + PERF_EVENT_COUNT];
+    if (::read(fds[PERF_CYCLES], buffer, sizeof(buffer)) < (ssize_t)(3 + opened) * 8) return false;
+
+    double scale = buffer[2] > 0 ? (double)buffer[1] / (double)buffer[2] : 1.0;
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+        values[i] = slots[i] >= 0 ? (uint64_t)(buffer[3 + slots[i]] * scale) : 0;
+    return true;
+#else
+    (void)values;
+    return false;
+#endif
+}
+
+
+/**
+ *  Marks the start of a phase
+ */
+void PerfCounters::begin(PerfPhase phase) {
+    (void)phase;
+    if (opened == 0 || !read(start)) memset(start, 0, sizeof(start));
+}
+
+
+/**
+ *  Marks the end of a phase, adding the counts since begin() to its totals
+ */
+void PerfCounters::end(PerfPhase phase) {
+    uint64_t now[PERF_EVENT_COUNT];
+    if (opened == 0 || !read(now)) return;
+
+    // Scaled counts can step back slightly when the multiplexing ratio changes
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+        if (now[i] > start[i]) totals[phase][i] += now[i] - start[i];
+    samples[phase]++;
+}
+
+
+const char* PerfCounters::getPhaseName(PerfPhase phase) {
+    static const char* names[PERF_PHASE_COUNT] = { "broadphase", "narrowphase", "solve", "integrate", "sleep" };
+    return names[phase];
+}
+
+
+const char* PerfCounters::getEventName(PerfEvent event) {
+    static const char* names[PERF_EVENT_COUNT] = { "cycles", "instructions", "llc_misses", "branch_misses" };
+    return names[event];
+}
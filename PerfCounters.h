@@ -0,0 +1,87 @@
+#ifndef __PERF_COUNTERS_H
+#define __PERF_COUNTERS_H
+
+#include <cstdint>
+
+
+/**
+ *  The phases of a physics step that counters are attributed to
+ */
+enum PerfPhase {
+    PERF_BROADPHASE,
+    PERF_NARROWPHASE,
+    PERF_SOLVE,
+    PERF_INTEGRATE,
+    PERF_SLEEP,
+    PERF_PHASE_COUNT
+};
+
+
+/**
+ *  The hardware events that are counted
+ */
+enum PerfEvent {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+};
+
+
+/**
+ *  Hardware performance counters, attributed to the phases of a physics step.
+ *
+ *  On Linux the events are opened as one perf_event_open group for the calling thread,
+ *  so they are scheduled together and can be compared with each other (e.g. instructions
+ *  per cycle, or LLC misses per instruction to tell cache-bound phases apart).
+ *  On other platforms, or when the kernel doesn't allow it, open() fails and nothing is counted.
+ */
+class PerfCounters {
+private:
+    int         fds[PERF_EVENT_COUNT];                          // One per event, -1 if unavailable
+    int         slots[PERF_EVENT_COUNT];                        // Where each event is in a group read
+    int         opened;                                         // Number of events in the group
+    uint64_t    start[PERF_EVENT_COUNT];                        // Counts when the current phase began
+    uint64_t    totals[PERF_PHASE_COUNT][PERF_EVENT_COUNT];     // Counts accumulated per phase
+    int         samples[PERF_PHASE_COUNT];                      // Number of times each phase ran
+
+    bool    read(uint64_t values[PERF_EVENT_COUNT]);
+
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    bool    open();
+    void    close();
+    void    reset();
+
+    void    begin(PerfPhase phase);
+    void    end(PerfPhase phase);
+
+    bool    isOpen()                                { return opened > 0; }
+    bool    hasEvent(PerfEvent event)               { return fds[event] >= 0; }
+    uint64_t getTotal(PerfPhase phase, PerfEvent event) { return totals[phase][event]; }
+    int     getSamples(PerfPhase phase)             { return samples[phase]; }
+
+    static const char* getPhaseName(PerfPhase phase);
+    static const char* getEventName(PerfEvent event);
+};
+
+
+/**
+ *  Counts a phase between its construction and destruction, does nothing if counters is null
+ */
+class PerfScope {
+private:
+    PerfCounters*   counters;
+    PerfPhase       phase;
+
+public:
+    PerfScope(PerfCounters* counters, PerfPhase phase) : counters(counters), phase(phase) {
+        if (counters) counters->begin(phase);
+    }
+    ~PerfScope() { if (counters) counters->end(phase); }
+};
+
+#endif // !__PERF_COUNTERS_H
@@ -0,0 +1,157 @@
+#include "PixelMask.h"
+#include "Math2D.h"
+
+#include <algorithm>
+
+#ifdef RBPHYS_SSE2
+#include <emmintrin.h>
+#endif
+
+
+PixelMask::PixelMask() {
+    width    = height = stride = 0;
+    boundsX0 = boundsY0 = boundsX1 = boundsY1 = 0;
+}
+
+
+/**
+ *  Copies a rectangle out of a bigger mask, e.g. one frame of a spritesheet's mask
+ *  @param mask - The mask, 1 bit per pixel in 64-bit words, bottom row first
+ *  @param maskStride - Words per row of the mask
+ *  @param x - Left of the rectangle in pixels
+ *  @param y - Bottom of the rectangle in pixels
+ *  @param width - Width of the rectangle in pixels
+ *  @param height - Height of the rectangle in pixels
+ */
+void PixelMask::build(const uint64_t* mask, int maskStride, int x, int y, int width, int height) {
+    this->width  = width;
+    this->height = height;
+    stride       = (width + 63) / 64 + 3;
+    words.assign((size_t)stride * height, 0);
+    boundsX0 = width;
+    boundsY0 = height;
+    boundsX1 = boundsY1 = 0;
+
+    for (int j = 0; j < height; j++) {
+        const uint64_t* source = &mask[(size_t)(y + j) * maskStride];
+        uint64_t*       row    = &words[(size_t)j * stride + 1];
+        for (int i = 0; i < (width + 63) / 64; i++) {
+            // The 64 pixels starting at x + 64i, the rest of the row cut off in the last word
+            int      bit   = x + 64 * i,
+                     shift = bit % 64;
+            uint64_t word  = source[bit / 64] >> shift;
+            if (shift && bit / 64 + 1 < maskStride) word |= source[bit / 64 + 1] << (64 - shift);
+            if (width - 64 * i < 64) word &= ((uint64_t)1 << (width - 64 * i)) - 1;
+            row[i] = word;
+            if (!word) continue;
+
+            int low = 0, high = 63;
+            while (!((word >> low) & 1))  low++;
+            while (!((word >> high) & 1)) high--;
+            boundsX0 = std::min(boundsX0, 64 * i + low);
+            boundsX1 = std::max(boundsX1, 64 * i + high + 1);
+            boundsY0 = std::min(boundsY0, j);
+            boundsY1 = j + 1;
+        }
+    }
+}
+
+
+/**
+ *  Computes the mass properties of the solid pixels, each a little box of uniform density
+ *  @param sizeX - Width the mask is stretched to, centred on the origin (e.g. the sprite's size)
+ *  @param sizeY - Height the mask is stretched to
+ *  @param density - Mass per unit area
+ *  @param densityMap - Scales the density of each pixel, width * height values, bottom row first (optional)
+ */
+MassData PixelMask::computeMassData(float sizeX, float sizeY, float density, const float* densityMap /*= nullptr*/) const {
+    MassData data;
+    data.mass    = data.inertia = 0.f;
+    data.center  = Vec2();
+    if (isEmpty()) return data;
+
+    // Sums in pixels, from the middle of the mask, scaled once at the end
+    double mass = 0.0, momentX = 0.0, momentY = 0.0, second = 0.0;
+    for (int y = boundsY0; y < boundsY1; y++) {
+        const uint64_t* row     = getRow(y);
+        double          centerY = y + 0.5 - height * 0.5;
+        for (int w = boundsX0 / 64; w <= (boundsX1 - 1) / 64; w++) {
+            for (uint64_t word = row[w]; word; word &= word - 1) {
+                int bit = 0;
+                while (!((word >> bit) & 1)) bit++;
+
+                int    x       = 64 * w + bit;
+                double weight  = densityMap ? densityMap[(size_t)y * width + x] : 1.0,
+                       centerX = x + 0.5 - width * 0.5;
+                mass    += weight;
+                momentX += weight * centerX;
+                momentY += weight * centerY;
+                second  += weight * (centerX * centerX * sizeX * sizeX / ((double)width * width) +
+                                     centerY * centerY * sizeY * sizeY / ((double)height * height));
+            }
+        }
+    }
+    if (mass <= 0.0) return data;
+
+    // Each pixel is a box of pixelX by pixelY around its centre
+    double pixelX = sizeX / width, pixelY = sizeY / height,
+           area   = pixelX * pixelY;
+    Vec2   center = Vec2((float)(momentX / mass * pixelX), (float)(momentY / mass * pixelY));
+    data.mass    = (float)(density * area * mass);
+    data.center  = center;
+    data.inertia = (float)(density * area * (second + mass * (pixelX * pixelX + pixelY * pixelY) / 12.0))
+                 - data.mass * dot(center, center);
+    return data;
+}
+
+
+/**
+ *  Tests whether any solid pixel of another mask lands on a solid pixel of this one
+ *  @param other - The other mask, at the same scale and unrotated
+ *  @param offsetX - Where the other mask's left edge is, in this mask's pixels
+ *  @param offsetY - Where the other mask's bottom edge is, in this mask's pixels
+ */
+bool PixelMask::overlaps(const PixelMask& other, int offsetX, int offsetY) const {
+    // Separating axis test of the tight boxes, and the pixels they share
+    int x0 = std::max(boundsX0, other.boundsX0 + offsetX),
+        x1 = std::min(boundsX1, other.boundsX1 + offsetX),
+        y0 = std::max(boundsY0, other.boundsY0 + offsetY),
+        y1 = std::min(boundsY1, other.boundsY1 + offsetY);
+    if (x0 >= x1 || y0 >= y1) return false;
+
+    // This mask's word w lines up with the other's bits from 64w - offsetX, which starts
+    // `shift` bits into the other's word `first` (at least -1, into the row's padding)
+    int firstWord = x0 / 64,
+        lastWord  = (x1 - 1) / 64,
+        bit       = 64 * firstWord - offsetX,
+        first     = (bit + 64) / 64 - 1,
+        shift     = bit - 64 * first;
+
+#ifdef RBPHYS_SSE2
+    const __m128i zero       = _mm_setzero_si128();
+    const __m128i shiftRight = _mm_cvtsi32_si128(shift),
+                  shiftLeft  = _mm_cvtsi32_si128(64 - shift);   // 64 shifts everything out
+#endif
+
+    for (int y = y0; y < y1; y++) {
+        const uint64_t* row      = getRow(y);
+        const uint64_t* otherRow = other.getRow(y - offsetY);
+#ifdef RBPHYS_SSE2
+        // Two words a time; the one past lastWord is padding or outside the shared box
+        for (int w = firstWord, k = first; w <= lastWord; w += 2, k += 2) {
+            __m128i low    = _mm_loadu_si128((const __m128i*)&otherRow[k]),
+                    high   = _mm_loadu_si128((const __m128i*)&otherRow[k + 1]),
+                    window = _mm_or_si128(_mm_srl_epi64(low, shiftRight), _mm_sll_epi64(high, shiftLeft)),
+                    both   = _mm_and_si128(_mm_loadu_si128((const __m128i*)&row[w]), window);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(both, zero)) != 0xFFFF) return true;
+        }
+#else
+        for (int w = firstWord, k = first; w <= lastWord; w++, k++) {
+            uint64_t window = otherRow[k] >> shift;
+            if (shift) window |= otherRow[k + 1] << (64 - shift);
+            if (row[w] & window) return true;
+        }
+#endif
+    }
+    return false;
+}
@@ -0,0 +1,45 @@
+#ifndef __PIXEL_MASK_H
+#define __PIXEL_MASK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Shape.h"
+
+
+/**
+ *  A 1-bit mask of a sprite frame's solid pixels, for pixel-exact overlap tests.
+ *
+ *  Rows are 64-bit words, bottom row first, with a zero word in front of each row and two
+ *  behind it, so an overlap test can read a shifted window of the other mask's row at any
+ *  offset without bounds checks. overlaps() first checks the tight boxes around the solid
+ *  pixels, then ANDs the rows they share, two words at a time with SSE2.
+ *  computeMassData() integrates the solid pixels for a body's mass properties.
+ */
+class PixelMask {
+private:
+    std::vector<uint64_t>   words;
+    int                     width,
+                            height,
+                            stride;         // Words per row, padding included
+    int                     boundsX0,       // Tight box around the solid pixels, empty if x0 >= x1
+                            boundsY0,
+                            boundsX1,
+                            boundsY1;
+
+    const uint64_t* getRow(int y) const     { return &words[(size_t)y * stride + 1]; }
+
+public:
+    PixelMask();
+
+    void    build(const uint64_t* mask, int maskStride, int x, int y, int width, int height);
+    bool    overlaps(const PixelMask& other, int offsetX, int offsetY) const;
+    MassData computeMassData(float sizeX, float sizeY, float density, const float* densityMap = nullptr) const;
+
+    bool    getBit(int x, int y) const      { return (getRow(y)[x / 64] >> (x % 64)) & 1; }
+    int     getWidth() const                { return width; }
+    int     getHeight() const               { return height; }
+    bool    isEmpty() const                 { return boundsX0 >= boundsX1; }
+};
+
+#endif // !__PIXEL_MASK_H
@@ -0,0 +1,178 @@
+#include "Profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define RBPHYS_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define RBPHYS_RDTSC
+#endif
+
+#define PROFILER_RING_SIZE 65536    // Zones kept per thread, older ones are overwritten
+
+
+/**
+ *  A recorded zone
+ */
+struct ProfileEvent {
+    const char* name;
+    uint64_t    start,
+                end;
+};
+
+
+/**
+ *  The zones of one thread
+ */
+struct ThreadBuffer {
+    int                     tid;
+    std::string             name;
+    std::atomic<uint64_t>   head;       // Total number of zones written
+    ProfileEvent            events[PROFILER_RING_SIZE];
+};
+
+
+// Buffers are never freed, so the zones of finished threads can still be exported
+static std::mutex                   registryMutex;
+static std::vector<ThreadBuffer*>   registry;
+static thread_local ThreadBuffer*   localBuffer = nullptr;
+
+
+/**
+ *  Reads the steady clock in nanoseconds
+ */
+static uint64_t steadyNow() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/**
+ *  The timestamps at start-up, used to convert ticks to microseconds when exporting
+ */
+static struct {
+    uint64_t ticks = Profiler::now();
+    uint64_t nanos = steadyNow();
+} epoch;
+
+
+/**
+ *  Gets the buffer of the calling thread, creating it on first use
+ */
+static ThreadBuffer* getBuffer() {
+    if (!localBuffer) {
+        localBuffer = new ThreadBuffer();
+        localBuffer->head = 0;
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        localBuffer->tid = (int)registry.size() + 1;
+        registry.push_back(localBuffer);
+    }
+    return localBuffer;
+}
+
+
+/**
+ *  Gets a timestamp, in CPU ticks where rdtsc is available and nanoseconds otherwise
+ */
+uint64_t Profiler::now() {
+#ifdef RBPHYS_RDTSC
+    return __rdtsc();
+#else
+    return steadyNow();
+#endif
+}
+
+
+/**
+ *  Records a zone for the calling thread
+ *  @param name - The name of the zone, must outlive the profiler (a string literal)
+ *  @param start - The timestamp when the zone started
+ *  @param end - The timestamp when the zone ended
+ */
+void Profiler::record(const char* name, uint64_t start, uint64_t end) {
+    ThreadBuffer*   buffer = getBuffer();
+    uint64_t        head   = buffer->head.load(std::memory_order_relaxed);
+
+    ProfileEvent& e = buffer->events[head % PROFILER_RING_SIZE];
+    e.name  = name;
+    e.start = start;
+    e.end   = end;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+
+/**
+ *  Names the calling thread in the exported trace. The name is read by exportChromeTrace()
+ *  from another thread, so it's written under the registry lock.
+ */
+void Profiler::setThreadName(const char* name) {
+    ThreadBuffer* buffer = getBuffer();
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer->name = name;
+}
+
+
+/**
+ *  Forgets all recorded zones
+ */
+void Profiler::clear() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (ThreadBuffer* buffer : registry)
+        buffer->head = 0;
+}
+
+
+/**
+ *  Writes the recorded zones of all threads as Chrome trace JSON.
+ *  Zones recorded while exporting may be torn, which is fine for a debugging aid.
+ *  @param path - The file to write
+ *  @return Whether the file could be written
+ */
+bool Profiler::exportChromeTrace(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+
+    // How many ticks there are per microsecond
+    double ticksPerUs = 1000.0;
+#ifdef RBPHYS_RDTSC
+    uint64_t ticks = now(), nanos = steadyNow();
+    if (nanos > epoch.nanos)
+        ticksPerUs = (double)(ticks - epoch.ticks) / ((nanos - epoch.nanos) / 1000.0);
+#endif
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    fprintf(file, "{\"traceEvents\":[\n");
+
+    bool first = true;
+    for (ThreadBuffer* buffer : registry) {
+        if (!buffer->name.empty()) {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", buffer->tid, buffer->name.c_str());
+            first = false;
+        }
+
+        uint64_t head  = buffer->head.load(std::memory_order_acquire),
+                 count = head < PROFILER_RING_SIZE ? head : PROFILER_RING_SIZE;
+        for (uint64_t i = head - count; i < head; i++) {
+            const ProfileEvent& e = buffer->events[i % PROFILER_RING_SIZE];
+            fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    first ? "" : ",\n", e.name, buffer->tid,
+                    (double)(int64_t)(e.start - epoch.ticks) / ticksPerUs,
+                    (double)(e.end - e.start) / ticksPerUs);
+            first = false;
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
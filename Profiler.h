@@ -0,0 +1,52 @@
+#ifndef __PROFILER_H
+#define __PROFILER_H
+
+#include <cstdint>
+
+
+/**
+ *  A lightweight instrumenting profiler.
+ *
+ *  Zones are recorded into a ring buffer per thread (no locks on the hot path) and can be
+ *  exported as Chrome trace JSON (chrome://tracing or ui.perfetto.dev) at any time.
+ *  Use the PROFILE_* macros rather than the class directly, so they compile out when
+ *  RBPHYS_PROFILE isn't defined (it isn't in release builds).
+ */
+class Profiler {
+public:
+    static uint64_t now();
+    static void     record(const char* name, uint64_t start, uint64_t end);
+    static void     setThreadName(const char* name);
+    static bool     exportChromeTrace(const char* path);
+    static void     clear();
+};
+
+
+/**
+ *  Records the time between its construction and destruction as a zone
+ */
+class ProfileZone {
+private:
+    const char* name;
+    uint64_t    start;
+
+public:
+    ProfileZone(const char* name) : name(name), start(Profiler::now()) {}
+    ~ProfileZone() { Profiler::record(name, start, Profiler::now()); }
+};
+
+
+#define RBPHYS_CONCAT_(a, b) a##b
+#define RBPHYS_CONCAT(a, b)  RBPHYS_CONCAT_(a, b)
+
+#ifdef RBPHYS_PROFILE
+#define PROFILE_ZONE(name)          ProfileZone RBPHYS_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name)   Profiler::setThreadName(name)
+#define PROFILE_EXPORT(path)        Profiler::exportChromeTrace(path)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_THREAD_NAME(name)
+#define PROFILE_EXPORT(path)        false
+#endif
+
+#endif // !__PROFILER_H
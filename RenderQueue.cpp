@@ -0,0 +1,170 @@
+#include "RenderQueue.h"
+
+#include <cstring>
+#include <utility>
+
+#define RADIX_BITS      8
+#define RADIX_BUCKETS   (1 << RADIX_BITS)
+#define RADIX_PASSES    (64 / RADIX_BITS)
+
+
+/**
+ *  @param batch - Draws the sorted sprites. Its shader is used for submissions with shader 0.
+ */
+RenderQueue::RenderQueue(SpriteBatch& batch) : batch(batch) {
+    drawCalls = 0;
+}
+
+
+/**
+ *  Packs a sort key. Fields that are too large are clamped.
+ *  @param layer - Drawn in increasing order
+ *  @param shader - Small id of the shader
+ *  @param texture - Small id of the texture
+ *  @param depth - Drawn in increasing order within the same layer, shader and texture
+ */
+uint64_t RenderQueue::makeKey(uint32_t layer, uint32_t shader, uint32_t texture, float depth) {
+    const uint32_t layerMax   = (1u << RENDER_QUEUE_LAYER_BITS) - 1,
+                   shaderMax  = (1u << RENDER_QUEUE_SHADER_BITS) - 1,
+                   textureMax = (1u << RENDER_QUEUE_TEXTURE_BITS) - 1;
+
+    // Flipping the sign bit of positive floats and every bit of negative ones makes them sort as integers
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    bits ^= (bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+
+    return (uint64_t)(layer   < layerMax   ? layer   : layerMax)   << (RENDER_QUEUE_SHADER_BITS + RENDER_QUEUE_TEXTURE_BITS + RENDER_QUEUE_DEPTH_BITS)
+         | (uint64_t)(shader  < shaderMax  ? shader  : shaderMax)  << (RENDER_QUEUE_TEXTURE_BITS + RENDER_QUEUE_DEPTH_BITS)
+         | (uint64_t)(texture < textureMax ? texture : textureMax) << RENDER_QUEUE_DEPTH_BITS
+         | bits;
+}
+
+
+/**
+ *  Gets the key field of a GL name, giving it the next free one the first time.
+ *  GL names can be anything, so they're numbered in the order they're first seen in the
+ *  frame to fit the key. Past the field's range names share the last id, which only costs
+ *  batching: runs are split on the real names.
+ */
+uint32_t RenderQueue::getId(std::unordered_map<GLuint, uint32_t>& ids, GLuint name, int bits) {
+    auto it = ids.find(name);
+    if (it != ids.end()) return it->second;
+
+    uint32_t id = (uint32_t)ids.size();
+    if (id > (1u << bits) - 1) id = (1u << bits) - 1;
+    ids[name] = id;
+    return id;
+}
+
+
+/**
+ *  Starts a new frame, forgetting the submissions of the previous one. The ids are handed
+ *  out again too, so names that are deleted and reused by GL (e.g. textures evicted from
+ *  the cache) don't use up the key fields over a long run.
+ */
+void RenderQueue::begin() {
+    entries.clear();
+    instances.clear();
+    states.clear();
+    shaderIds.clear();
+    textureIds.clear();
+}
+
+
+/**
+ *  Queues a sprite
+ *  @param layer - Layers are drawn in increasing order (0-255)
+ *  @param shader - A program using the batch shader's attributes (0 = the batch's own)
+ *  @param texture - The sprite's texture
+ *  @param depth - Order within sprites of the same layer, shader and texture, lowest first
+ *  @param transform - Position and rotation of the sprite's centre
+ *  @param sizeX - How wide the sprite is on the screen (2=full width)
+ *  @param sizeY - How high the sprite is on the screen (2=full height)
+ *  @param texRect - The spritesheet's rectangle in the texture (or the whole image to draw)
+ *  @param sheetGrid - First column, first row, columns and rows of the animation (null = one tile)
+ *  @param frame - The animation step
+ *  @param tint - Colour the texture is multiplied with (0xRRGGBBAA)
+ */
+void RenderQueue::submit(int layer, GLuint shader, GLuint texture, float depth,
+                         const Transform2D& transform, float sizeX, float sizeY, const floatRect& texRect,
+                         const int sheetGrid[4] /*= nullptr*/, int frame /*= 0*/, uint32_t tint /*= 0xFFFFFFFF*/) {
+    if (!shader) shader = batch.getShader();
+
+    SortEntry entry;
+    entry.key   = makeKey(layer > 0 ? (uint32_t)layer : 0,
+                          getId(shaderIds, shader, RENDER_QUEUE_SHADER_BITS),
+                          getId(textureIds, texture, RENDER_QUEUE_TEXTURE_BITS),
+                          depth);
+    entry.index = (uint32_t)instances.size();
+    entries.push_back(entry);
+
+    DrawState state = { shader, texture };
+    states.push_back(state);
+    instances.push_back(SpriteBatch::makeInstance(transform, sizeX, sizeY, texRect, sheetGrid, frame, tint));
+}
+
+
+/**
+ *  Sorts the keys with a least significant digit radix sort, which is stable.
+ *  All histograms are counted in one pass, and digits that are the same in every key
+ *  (usually most of the layer and id bits) are skipped.
+ */
+void RenderQueue::sort() {
+    size_t count = entries.size();
+    if (count < 2) return;
+
+    uint32_t histograms[RADIX_PASSES][RADIX_BUCKETS] = {};
+    for (const SortEntry& entry : entries) {
+        for (int pass = 0; pass < RADIX_PASSES; pass++)
+            histograms[pass][(entry.key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+    }
+
+    scratch.resize(count);
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+        uint32_t* histogram = histograms[pass];
+        int       shift     = pass * RADIX_BITS;
+        if (histogram[(entries[0].key >> shift) & (RADIX_BUCKETS - 1)] == count) continue;
+
+        // Counts to starting positions
+        uint32_t position = 0;
+        for (int bucket = 0; bucket < RADIX_BUCKETS; bucket++) {
+            uint32_t n = histogram[bucket];
+            histogram[bucket] = position;
+            position += n;
+        }
+
+        for (const SortEntry& entry : entries)
+            scratch[histogram[(entry.key >> shift) & (RADIX_BUCKETS - 1)]++] = entry;
+        std::swap(entries, scratch);
+    }
+}
+
+
+/**
+ *  Sorts the submissions and draws them, one draw call per run of the same shader and texture
+ */
+void RenderQueue::flush() {
+    drawCalls = 0;
+    if (entries.empty()) return;
+
+    sort();
+
+    // Gather the instances in key order, cutting runs where the state changes
+    sorted.resize(entries.size());
+    runs.clear();
+    for (size_t i = 0; i < entries.size(); i++) {
+        uint32_t index = entries[i].index;
+        sorted[i] = instances[index];
+
+        const DrawState& state = states[index];
+        if (!runs.empty() && runs.back().shader == state.shader && runs.back().texture == state.texture) {
+            runs.back().count++;
+            continue;
+        }
+        SpriteRun run = { state.shader, state.texture, 1 };
+        runs.push_back(run);
+    }
+
+    batch.draw(&sorted[0], &runs[0], runs.size());
+    drawCalls = batch.getDrawCalls();
+}
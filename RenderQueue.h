@@ -0,0 +1,71 @@
+#ifndef __RENDER_QUEUE_H
+#define __RENDER_QUEUE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "SpriteBatch.h"
+
+#define RENDER_QUEUE_LAYER_BITS     8
+#define RENDER_QUEUE_SHADER_BITS    12
+#define RENDER_QUEUE_TEXTURE_BITS   12
+#define RENDER_QUEUE_DEPTH_BITS     32
+
+
+/**
+ *  Collects the sprites of a frame and draws them sorted, whatever order they are submitted in.
+ *
+ *  Each submission gets a 64-bit key, from the most to the least significant bits:
+ *  layer | shader | texture | depth. Sorting the keys puts layers in order, and within a
+ *  layer keeps sprites of the same shader and texture together, so they end up in the
+ *  same instanced draw call. Depth only orders sprites within such a run; sprites that must
+ *  overlap in a certain order across textures belong on different layers.
+ *  Equal keys keep their submission order.
+ */
+class RenderQueue {
+private:
+    /**
+     *  What gets sorted: the key and where the submission's data is
+     */
+    struct SortEntry {
+        uint64_t    key;
+        uint32_t    index;
+    };
+
+    /**
+     *  The state a submission is drawn with
+     */
+    struct DrawState {
+        GLuint      shader;
+        GLuint      texture;
+    };
+
+    SpriteBatch&                        batch;
+    std::vector<SortEntry>              entries, scratch;
+    std::vector<SpriteInstance>         instances, sorted;
+    std::vector<DrawState>              states;
+    std::vector<SpriteRun>              runs;
+    std::unordered_map<GLuint, uint32_t> shaderIds, textureIds;    // GL names to key fields, this frame
+    int                                 drawCalls;
+
+    static uint32_t getId(std::unordered_map<GLuint, uint32_t>& ids, GLuint name, int bits);
+    void            sort();
+
+public:
+    RenderQueue(SpriteBatch& batch);
+
+    void    begin();
+    void    submit(int layer, GLuint shader, GLuint texture, float depth,
+                   const Transform2D& transform, float sizeX, float sizeY, const floatRect& texRect,
+                   const int sheetGrid[4] = nullptr, int frame = 0, uint32_t tint = 0xFFFFFFFF);
+    void    flush();
+
+    static uint64_t makeKey(uint32_t layer, uint32_t shader, uint32_t texture, float depth);
+
+    size_t  getSize()               { return entries.size(); }
+    int     getDrawCalls()          { return drawCalls; }
+};
+
+#endif // !__RENDER_QUEUE_H
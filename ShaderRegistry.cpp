@@ -0,0 +1,263 @@
+#include "ShaderRegistry.h"
+#include "functions.h"
+#include "GLState.h"
+
+#include <GLFW/glfw3.h>
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#define MAKE_DIRECTORY(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define MAKE_DIRECTORY(path) mkdir(path, 0755)
+#endif
+
+// ARB_get_program_binary isn't in the GL 3.3 loader, so it is loaded by hand
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT  0x8257
+#define GL_PROGRAM_BINARY_LENGTH            0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS       0x87FE
+#endif
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+static PFNGLGETPROGRAMBINARYPROC    getProgramBinary    = nullptr;
+static PFNGLPROGRAMBINARYPROC       programBinary       = nullptr;
+static PFNGLPROGRAMPARAMETERIPROC   programParameteri   = nullptr;
+
+#define SHADER_BINARY_MAGIC 0x42534252u    // "RBSB"
+
+
+/**
+ *  64-bit FNV-1a hash, continuing from a previous hash
+ */
+static uint64_t hashString(const std::string& s, uint64_t hash = 14695981039346656037ull) {
+    for (unsigned char c : s) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return (hash ^ 0xFF) * 1099511628211ull;   // Separator, so "ab"+"c" and "a"+"bc" differ
+}
+
+
+/**
+ *  Checks for (and loads) the program binary functions. A context must be current.
+ */
+bool ShaderRegistry::hasProgramBinary() {
+    static int supported = -1;
+    if (supported >= 0) return supported != 0;
+
+    GLint major = 0, minor = 0, formats = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool available = major > 4 || (major == 4 && minor >= 1);
+
+    GLint extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+    for (GLint i = 0; i < extensions && !available; i++) {
+        const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        available = name && !strcmp(name, "GL_ARB_get_program_binary");
+    }
+
+    // Some drivers expose the functions but no formats to save in
+    if (available) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (available && formats > 0) {
+        getProgramBinary  = (PFNGLGETPROGRAMBINARYPROC)glfwGetProcAddress("glGetProgramBinary");
+        programBinary     = (PFNGLPROGRAMBINARYPROC)glfwGetProcAddress("glProgramBinary");
+        programParameteri = (PFNGLPROGRAMPARAMETERIPROC)glfwGetProcAddress("glProgramParameteri");
+    }
+    supported = getProgramBinary && programBinary && programParameteri;
+    return supported != 0;
+}
+
+
+/**
+ *  @param cacheDirectory - Where program binaries are kept (empty = don't cache them)
+ */
+ShaderRegistry::ShaderRegistry(const std::string& cacheDirectory /*= "shader_cache"*/) {
+    this->cacheDirectory = cacheDirectory;
+    binaryLoads = 0;
+    compiles    = 0;
+
+    const char* vendor   = (const char*)glGetString(GL_VENDOR);
+    const char* renderer = (const char*)glGetString(GL_RENDERER);
+    const char* version  = (const char*)glGetString(GL_VERSION);
+    driver = std::string(vendor ? vendor : "") + "|" + (renderer ? renderer : "") + "|" + (version ? version : "");
+}
+
+
+ShaderRegistry::~ShaderRegistry() {
+    for (auto& it : programs) {
+        GLState::deleteProgram(it.second->program);
+        delete it.second;
+    }
+}
+
+
+/**
+ *  Gets a program that was already created
+ *  @param name - The program's name
+ *  @return The program, null if there is none by that name
+ */
+ShaderProgram* ShaderRegistry::get(const std::string& name) {
+    auto it = programs.find(name);
+    return it == programs.end() ? nullptr : it->second;
+}
+
+
+/**
+ *  Gets a program, creating it the first time: from the binary cache if there is a
+ *  matching binary, otherwise by compiling the sources
+ *  @param name - The program's name
+ *  @param vertexShader - The vertex shader
+ *  @param fragmentShader - The fragment shader
+ *  @param geometryShader - The geometry shader (if there is any)
+ *  @return The program, owned by the registry
+ */
+ShaderProgram* ShaderRegistry::get(const std::string& name,
+                                   const std::string& vertexShader,
+                                   const std::string& fragmentShader,
+                                   const std::string& geometryShader /*= ""*/) {
+    ShaderProgram* program = get(name);
+    if (program) return program;
+
+    program = new ShaderProgram();
+    program->program = 0;
+
+    // The binary is only valid for exactly these sources on exactly this driver
+    std::string path;
+    bool binaries = !cacheDirectory.empty() && hasProgramBinary();
+    if (binaries) {
+        uint64_t hash = hashString(driver, hashString(geometryShader, hashString(fragmentShader, hashString(vertexShader))));
+        char file[32];
+        snprintf(file, sizeof(file), "/%016llx.bin", (unsigned long long)hash);
+        path = cacheDirectory + file;
+
+        program->program = glCreateProgram();
+        if (loadBinary(program->program, path)) binaryLoads++;
+        else {
+            GLState::deleteProgram(program->program);
+            program->program = 0;
+        }
+    }
+
+    if (!program->program) {
+        program->program = CompileShader(vertexShader, fragmentShader, geometryShader);
+        compiles++;
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program->program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            char log[1024];
+            glGetProgramInfoLog(program->program, sizeof(log), nullptr, log);
+            std::cerr << "Shader program \"" << name << "\" failed to link: " << log << '\n';
+        }
+        else if (binaries) {
+            // Linking again with the hint makes sure the driver keeps a binary to hand out
+            programParameteri(program->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            glLinkProgram(program->program);
+            saveBinary(program->program, path);
+        }
+    }
+
+    cacheUniforms(*program);
+    programs[name] = program;
+    return program;
+}
+
+
+/**
+ *  Loads a program binary from the disk cache
+ *  @return Whether the file exists, was made by this driver and was accepted
+ */
+bool ShaderRegistry::loadBinary(GLuint program, const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    // Header: magic, driver string, binary format and length
+    uint32_t magic = 0, driverLength = 0, length = 0;
+    GLenum   format = 0;
+    bool ok = fread(&magic, 4, 1, file) == 1 && magic == SHADER_BINARY_MAGIC &&
+              fread(&driverLength, 4, 1, file) == 1 && driverLength == driver.size();
+
+    std::string fileDriver(driverLength, '\0');
+    std::vector<char> binary;
+    if (ok) ok = fread(&fileDriver[0], 1, driverLength, file) == driverLength && fileDriver == driver &&
+                 fread(&format, sizeof(format), 1, file) == 1 &&
+                 fread(&length, 4, 1, file) == 1 && length > 0;
+    if (ok) {
+        binary.resize(length);
+        ok = fread(&binary[0], 1, length, file) == length;
+    }
+    fclose(file);
+    if (!ok) return false;
+
+    programBinary(program, format, &binary[0], (GLsizei)length);
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    return linked == GL_TRUE;
+}
+
+
+/**
+ *  Saves a linked program's binary to the disk cache
+ */
+void ShaderRegistry::saveBinary(GLuint program, const std::string& path) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum  format  = 0;
+    GLsizei written = 0;
+    getProgramBinary(program, length, &written, &format, &binary[0]);
+    if (written <= 0) return;
+
+    MAKE_DIRECTORY(cacheDirectory.c_str());
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Could not write the shader cache " << path << '\n';
+        return;
+    }
+
+    uint32_t magic = SHADER_BINARY_MAGIC, driverLength = (uint32_t)driver.size(), size = (uint32_t)written;
+    fwrite(&magic, 4, 1, file);
+    fwrite(&driverLength, 4, 1, file);
+    fwrite(driver.data(), 1, driverLength, file);
+    fwrite(&format, sizeof(format), 1, file);
+    fwrite(&size, 4, 1, file);
+    fwrite(&binary[0], 1, size, file);
+    fclose(file);
+}
+
+
+/**
+ *  Looks up the location of every active uniform once, right after linking
+ */
+void ShaderRegistry::cacheUniforms(ShaderProgram& program) {
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(program.program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program.program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<char> name(maxLength > 0 ? maxLength : 1);
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint   size   = 0;
+        GLenum  type   = 0;
+        glGetActiveUniform(program.program, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, &name[0]);
+
+        std::string uniform(&name[0], length);
+        GLint location = glGetUniformLocation(program.program, uniform.c_str());
+        program.uniforms[uniform] = location;
+
+        // Arrays are reported as "name[0]", but are usually looked up as "name"
+        if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+            program.uniforms[uniform.substr(0, uniform.size() - 3)] = location;
+    }
+}
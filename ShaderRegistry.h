@@ -0,0 +1,61 @@
+#ifndef __SHADER_REGISTRY_H
+#define __SHADER_REGISTRY_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+
+/**
+ *  A linked shader program and the locations of all its active uniforms
+ */
+struct ShaderProgram {
+    GLuint                                  program;
+    std::unordered_map<std::string, GLint>  uniforms;
+
+    GLint   getUniform(const std::string& name) const {
+        auto it = uniforms.find(name);
+        return it == uniforms.end() ? -1 : it->second;
+    }
+};
+
+
+/**
+ *  Compiles each shader program once and owns it.
+ *
+ *  Programs are looked up by name. Where the driver supports program binaries (GL 4.1 or
+ *  ARB_get_program_binary), linked programs are saved to the cache directory, keyed by a
+ *  hash of their sources and the driver's vendor, renderer and version strings, so the next
+ *  start can skip compiling GLSL. A binary the driver rejects is simply recompiled.
+ */
+class ShaderRegistry {
+private:
+    std::string                                         cacheDirectory;
+    std::unordered_map<std::string, ShaderProgram*>     programs;
+    std::string                                         driver;         // Vendor, renderer and version
+    int                                                 binaryLoads,    // Programs loaded from the disk cache
+                                                        compiles;       // Programs compiled from source
+
+    bool    loadBinary(GLuint program, const std::string& path);
+    void    saveBinary(GLuint program, const std::string& path);
+    void    cacheUniforms(ShaderProgram& program);
+
+public:
+    ShaderRegistry(const std::string& cacheDirectory = "shader_cache");
+    ~ShaderRegistry();
+
+    ShaderProgram*  get(const std::string& name);
+    ShaderProgram*  get(const std::string& name,
+                        const std::string& vertexShader,
+                        const std::string& fragmentShader,
+                        const std::string& geometryShader = "");
+
+    int     getBinaryLoadCount()        { return binaryLoads; }
+    int     getCompileCount()           { return compiles; }
+
+    static bool hasProgramBinary();
+};
+
+#endif // !__SHADER_REGISTRY_H
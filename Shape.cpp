@@ -0,0 +1,246 @@
+#include "Shape.h"
+
+#include <algorithm>
+#include <vector>
+
+
+/**
+ *  Creates a circle
+ *  @param radius - The radius of the circle
+ *  @param center - The centre of the circle in the body's local space
+ */
+Shape makeCircle(float radius, const Vec2& center /*= Vec2()*/) {
+    Shape shape;
+    shape.type        = SHAPE_CIRCLE;
+    shape.radius      = radius;
+    shape.count       = 0;
+    shape.vertices[0] = center;
+    return shape;
+}
+
+
+/**
+ *  Creates a box centred on the body's origin
+ *  @param halfWidth - Half of the box's width
+ *  @param halfHeight - Half of the box's height
+ */
+Shape makeBox(float halfWidth, float halfHeight) {
+    Vec2 points[4] = {
+        Vec2(-halfWidth, -halfHeight),
+        Vec2( halfWidth, -halfHeight),
+        Vec2( halfWidth,  halfHeight),
+        Vec2(-halfWidth,  halfHeight)
+    };
+    return makePolygon(points, 4);
+}
+
+
+/**
+ *  Creates a box placed and turned in the body's local space, e.g. as a part of a compound body
+ *  @param halfWidth - Half of the box's width
+ *  @param halfHeight - Half of the box's height
+ *  @param center - The centre of the box in the body's local space
+ *  @param angle - The angle of the box in radians (anti-clockwise)
+ */
+Shape makeBox(float halfWidth, float halfHeight, const Vec2& center, float angle /*= 0.f*/) {
+    float c = cos(angle), s = sin(angle);
+    Vec2 points[4] = {
+        center + rotate(Vec2(-halfWidth, -halfHeight), c, s),
+        center + rotate(Vec2( halfWidth, -halfHeight), c, s),
+        center + rotate(Vec2( halfWidth,  halfHeight), c, s),
+        center + rotate(Vec2(-halfWidth,  halfHeight), c, s)
+    };
+    return makePolygon(points, 4);
+}
+
+
+/**
+ *  Creates a convex polygon from the convex hull of the given points.
+ *  Points beyond MAX_POLYGON_VERTICES on the hull are dropped. If the hull is degenerate
+ *  (fewer than 3 points, or all of them on a line) the polygon is empty, with a count of 0.
+ *  @param points - The points, in the body's local space
+ *  @param count - The number of points
+ */
+Shape makePolygon(const Vec2* points, int count) {
+    Shape shape;
+    shape.type   = SHAPE_POLYGON;
+    shape.radius = 0.f;
+
+    // Sort the points lexicographically for the monotone chain
+    std::vector<Vec2> sorted(points, points + count);
+    std::sort(sorted.begin(), sorted.end(), [](const Vec2& a, const Vec2& b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+
+    // Build the lower and upper hulls (anti-clockwise)
+    std::vector<Vec2> hull(2 * sorted.size());
+    int k = 0;
+    for (int i = 0; i < (int)sorted.size(); i++) {
+        while (k >= 2 && cross(hull[k-1] - hull[k-2], sorted[i] - hull[k-2]) <= 0.f) k--;
+        hull[k++] = sorted[i];
+    }
+    for (int i = (int)sorted.size() - 2, t = k + 1; i >= 0; i--) {
+        while (k >= t && cross(hull[k-1] - hull[k-2], sorted[i] - hull[k-2]) <= 0.f) k--;
+        hull[k++] = sorted[i];
+    }
+    k = std::max(k - 1, 0);
+
+    // Fewer than 3 distinct points (or all on a line) enclose nothing: an empty shape
+    if (k < 3) {
+        shape.count = 0;
+        return shape;
+    }
+
+    // Copy vertices and compute the edge normals
+    shape.count = std::min(k, MAX_POLYGON_VERTICES);
+    for (int i = 0; i < shape.count; i++)
+        shape.vertices[i] = hull[i];
+    for (int i = 0; i < shape.count; i++) {
+        Vec2 edge = shape.vertices[(i + 1) % shape.count] - shape.vertices[i];
+        shape.normals[i] = normalize(cross(edge, 1.f));
+    }
+    return shape;
+}
+
+
+/**
+ *  Creates a one-sided edge, pushing out to the right going from v1 to v2
+ *  @param v1 - The first vertex, in the body's local space
+ *  @param v2 - The second vertex
+ *  @param previous - The chain's vertex before v1, or v1 if the chain starts there
+ *  @param next - The chain's vertex after v2, or v2 if the chain ends there
+ */
+Shape makeEdge(const Vec2& v1, const Vec2& v2, const Vec2& previous, const Vec2& next) {
+    Shape shape;
+    shape.type        = SHAPE_EDGE;
+    shape.radius      = 0.f;
+    shape.count       = 2;
+    shape.vertices[0] = v1;
+    shape.vertices[1] = v2;
+    shape.vertices[2] = previous;
+    shape.vertices[3] = next;
+    shape.normals[0]  = normalize(cross(v2 - v1, 1.f));
+    shape.normals[1]  = -shape.normals[0];
+    return shape;
+}
+
+
+/**
+ *  Creates the edges of a chain, each knowing its neighbours. Chains around solid ground
+ *  are wound anti-clockwise, like polygons, so their edges push outwards.
+ *  @param points - The chain's vertices, in the body's local space
+ *  @param count - The number of vertices
+ *  @param loop - Whether the last vertex joins back to the first
+ *  @param edges - Output edges, appended
+ */
+void makeChain(const Vec2* points, int count, bool loop, std::vector<Shape>& edges) {
+    int edgeCount = loop ? count : count - 1;
+    for (int i = 0; i < edgeCount; i++) {
+        int i1 = i, i2 = (i + 1) % count;
+        Vec2 previous = loop || i1 > 0         ? points[(i1 + count - 1) % count] : points[i1],
+             next     = loop || i2 < count - 1 ? points[(i2 + 1) % count]         : points[i2];
+        edges.push_back(makeEdge(points[i1], points[i2], previous, next));
+    }
+}
+
+
+/**
+ *  Computes the mass, centre of mass and rotational inertia of a shape
+ *  @param shape - The shape
+ *  @param density - Mass per unit area
+ */
+MassData computeMassData(const Shape& shape, float density) {
+    MassData data;
+    if (shape.type == SHAPE_CIRCLE) {
+        data.mass    = density * 3.14159265f * shape.radius * shape.radius;
+        data.center  = shape.vertices[0];
+        data.inertia = 0.5f * data.mass * shape.radius * shape.radius;
+        return data;
+    }
+    if (shape.type == SHAPE_EDGE) {
+        data.mass    = data.inertia = 0.f;
+        data.center  = 0.5f * (shape.vertices[0] + shape.vertices[1]);
+        return data;
+    }
+
+    // Sum up the triangles of a fan from the first vertex, which is closer than the origin
+    // for shapes far from it, so less precision is lost
+    Vec2  reference = shape.vertices[0], center;
+    float area = 0.f, I = 0.f;
+    for (int i = 1; i + 1 < shape.count; i++) {
+        Vec2    e1 = shape.vertices[i] - reference,
+                e2 = shape.vertices[i + 1] - reference;
+        float   D  = cross(e1, e2);
+        area   += 0.5f * D;
+        center += (0.5f * D / 3.f) * (e1 + e2);
+        I      += (0.25f / 3.f) * D * (dot(e1, e1) + dot(e1, e2) + dot(e2, e2));
+    }
+    if (area <= 0.f) {
+        data.mass    = data.inertia = 0.f;
+        data.center  = reference;
+        return data;
+    }
+    center *= 1.f / area;
+
+    // Inertia around the reference, moved to the centre of mass
+    data.mass    = density * area;
+    data.center  = reference + center;
+    data.inertia = density * I - data.mass * dot(center, center);
+    return data;
+}
+
+
+/**
+ *  Computes the mass, centre of mass and rotational inertia of the parts of a compound body together
+ *  @param shapes - The parts
+ *  @param count - The number of parts
+ *  @param density - Mass per unit area
+ */
+MassData computeMassData(const Shape* shapes, int count, float density) {
+    MassData data;
+    data.mass    = data.inertia = 0.f;
+    data.center  = Vec2();
+
+    std::vector<MassData> parts(count);
+    for (int i = 0; i < count; i++) {
+        parts[i]     = computeMassData(shapes[i], density);
+        data.mass   += parts[i].mass;
+        data.center += parts[i].mass * parts[i].center;
+    }
+    if (data.mass <= 0.f) return data;
+    data.center *= 1.f / data.mass;
+
+    // Each part's inertia moved to the common centre (parallel axis theorem)
+    for (int i = 0; i < count; i++)
+        data.inertia += parts[i].inertia + parts[i].mass * lengthSquared(parts[i].center - data.center);
+    return data;
+}
+
+
+/**
+ *  Computes the world-space bounding box of a shape
+ *  @param shape - The shape
+ *  @param transform - The transform of the shape's body
+ */
+AABB computeAABB(const Shape& shape, const Transform2D& transform) {
+    AABB box;
+    if (shape.type == SHAPE_CIRCLE) {
+        Vec2 center = mul(transform, shape.vertices[0]);
+        box.lower = Vec2(center.x - shape.radius, center.y - shape.radius);
+        box.upper = Vec2(center.x + shape.radius, center.y + shape.radius);
+        return box;
+    }
+
+    if (shape.count == 0) {
+        box.lower = box.upper = mul(transform, Vec2());
+        return box;
+    }
+
+    box.lower = box.upper = mul(transform, shape.vertices[0]);
+    for (int i = 1; i < shape.count; i++) {
+        Vec2 v = mul(transform, shape.vertices[i]);
+        box.lower = minVec(box.lower, v);
+        box.upper = maxVec(box.upper, v);
+    }
+    return box;
+}
@@ -0,0 +1,59 @@
+#ifndef __SHAPE_H
+#define __SHAPE_H
+
+#include "Math2D.h"
+#include "Transform2D.h"
+
+#include <vector>
+
+#define MAX_POLYGON_VERTICES 8
+
+
+/**
+ *  Enum type for the kinds of collision shapes.
+ */
+enum ShapeType {
+    SHAPE_CIRCLE, SHAPE_POLYGON, SHAPE_EDGE
+};
+
+
+/**
+ *  A collision shape in the local space of its body.
+ *  Polygons are convex and wound anti-clockwise.
+ *
+ *  Edges are one-sided segments of a chain, meant for static level geometry: they push shapes
+ *  out to their front (the right going from vertices[0] to [1]), and let shapes entirely
+ *  behind them through.
+ *  vertices[2] and [3] are the chain's vertices before and after the edge (ghost vertices),
+ *  or the edge's own ends where the chain stops, so an edge knows which of its ends are
+ *  corners things can be pushed around and which join a neighbour that takes over.
+ */
+struct Shape {
+    ShapeType   type;
+    float       radius;                             // Radius of a circle
+    int         count;                              // Number of vertices in a polygon, 2 for an edge
+    Vec2        vertices[MAX_POLYGON_VERTICES];     // Polygon or edge vertices, or the centre of a circle
+    Vec2        normals[MAX_POLYGON_VERTICES];      // Outward edge normals, normals[i] belongs to edge i -> i+1
+};
+
+/**
+ *  Mass, centre of mass and rotational inertia of a body part
+ */
+struct MassData {
+    float       mass;
+    Vec2        center;                             // Centre of mass, in the body's local space
+    float       inertia;                            // Around the centre of mass
+};
+
+Shape makeCircle (float radius, const Vec2& center = Vec2());
+Shape makeBox    (float halfWidth, float halfHeight);
+Shape makeBox    (float halfWidth, float halfHeight, const Vec2& center, float angle = 0.f);
+Shape makePolygon(const Vec2* points, int count);
+Shape makeEdge   (const Vec2& v1, const Vec2& v2, const Vec2& previous, const Vec2& next);
+void  makeChain  (const Vec2* points, int count, bool loop, std::vector<Shape>& edges);
+
+MassData computeMassData(const Shape& shape, float density);
+MassData computeMassData(const Shape* shapes, int count, float density);
+AABB  computeAABB(const Shape& shape, const Transform2D& transform);
+
+#endif // !__SHAPE_H
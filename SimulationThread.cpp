@@ -0,0 +1,124 @@
+#include "SimulationThread.h"
+#include "Profiler.h"
+
+#include <chrono>
+
+
+/**
+ *  @param world - The world to step, owned by the thread while it runs
+ *  @param timeStep - Simulated seconds per step, which is also how often it steps
+ *  @param maxCatchUp - When steps fall behind real time, how many are taken back to back
+ *                      before the rest is dropped (so the simulation slows down instead)
+ */
+SimulationThread::SimulationThread(World& world, float timeStep /*= 1.f / 60.f*/, int maxCatchUp /*= 4*/)
+    : world(world), running(false) {
+    this->timeStep   = timeStep;
+    this->maxCatchUp = maxCatchUp > 0 ? maxCatchUp : 1;
+    steps            = 0;
+
+    // Publish the starting state, so there is something to draw before the first step
+    publish(0.0);
+}
+
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+
+/**
+ *  Starts stepping, does nothing if it's already running
+ */
+void SimulationThread::start() {
+    if (running.exchange(true)) return;
+    thread = std::thread(&SimulationThread::run, this);
+}
+
+
+/**
+ *  Stops stepping and waits for the step in progress. Posted commands that didn't run yet
+ *  are run here, so the world is back to the calling thread afterwards.
+ */
+void SimulationThread::stop() {
+    if (!running.exchange(false)) return;
+    thread.join();
+    runCommands();
+}
+
+
+/**
+ *  Queues a command that runs on the simulation thread before the next step
+ *  @param command - Gets the world, which it may change
+ */
+void SimulationThread::post(const std::function<void(World&)>& command) {
+    std::lock_guard<std::mutex> lock(commandMutex);
+    commands.push_back(command);
+}
+
+
+/**
+ *  Takes the newest snapshot for getSnapshot() (render thread)
+ *  @return Whether there was a new one since the last call
+ */
+bool SimulationThread::update() {
+    return snapshots.update();
+}
+
+
+/**
+ *  Runs the posted commands, holding the lock only to take them
+ */
+void SimulationThread::runCommands() {
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        executing.swap(commands);
+    }
+    for (const std::function<void(World&)>& command : executing)
+        command(world);
+    executing.clear();
+}
+
+
+/**
+ *  Copies the world's state into the back snapshot and publishes it
+ */
+void SimulationThread::publish(double stepMs) {
+    WorldSnapshot& snapshot = snapshots.getBack();
+    snapshot.transforms.resize(world.getBodyCount());
+    if (!snapshot.transforms.empty()) world.getTransforms(&snapshot.transforms[0]);
+    snapshot.step   = steps;
+    snapshot.time   = steps * (double)timeStep;
+    snapshot.stepMs = stepMs;
+    snapshots.publish();
+}
+
+
+/**
+ *  The thread: steps whenever real time has passed a step's worth, sleeping in between
+ */
+void SimulationThread::run() {
+    typedef std::chrono::steady_clock clock;
+    PROFILE_THREAD_NAME("simulation");
+
+    const clock::duration period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(timeStep));
+    clock::time_point     next   = clock::now() + period;
+
+    while (running.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_until(next);
+
+        // Catch up on missed steps, but not endlessly: after a stall, drop the backlog
+        int behind = 0;
+        while (clock::now() >= next && behind < maxCatchUp) {
+            runCommands();
+
+            clock::time_point start = clock::now();
+            world.step(timeStep);
+            steps++;
+            publish(std::chrono::duration<double, std::milli>(clock::now() - start).count());
+
+            next += period;
+            behind++;
+        }
+        if (clock::now() >= next) next = clock::now() + period;
+    }
+}
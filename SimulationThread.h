@@ -0,0 +1,64 @@
+#ifndef __SIMULATION_THREAD_H
+#define __SIMULATION_THREAD_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Transform2D.h"
+#include "TripleBuffer.h"
+#include "World.h"
+
+
+/**
+ *  The state of the world after a step, as published to the render thread
+ */
+struct WorldSnapshot {
+    std::vector<Transform2D>    transforms;     // Of every body, by id
+    uint64_t                    step;           // Steps taken so far (0 = none yet)
+    double                      time;           // Simulated seconds so far
+    double                      stepMs;         // How long the step took
+};
+
+
+/**
+ *  Steps a world at a fixed rate on its own thread, publishing a snapshot after every step.
+ *
+ *  While the thread runs it owns the world: other threads must not touch it, but post()
+ *  commands that run on the simulation thread between steps. The render thread draws
+ *  from the newest snapshot (see update()), so a slow swap doesn't hold physics back and
+ *  a slow step doesn't hold the frame back.
+ */
+class SimulationThread {
+private:
+    World&                                      world;
+    float                                       timeStep;
+    int                                         maxCatchUp;         // Steps taken at most at once when behind
+    std::thread                                 thread;
+    std::atomic<bool>                           running;
+    TripleBuffer<WorldSnapshot>                 snapshots;
+    std::mutex                                  commandMutex;
+    std::vector<std::function<void(World&)>>    commands;           // Posted, guarded by commandMutex
+    std::vector<std::function<void(World&)>>    executing;          // Taken from commands, run without the lock
+    uint64_t                                    steps;
+
+    void    run();
+    void    runCommands();
+    void    publish(double stepMs);
+
+public:
+    SimulationThread(World& world, float timeStep = 1.f / 60.f, int maxCatchUp = 4);
+    ~SimulationThread();
+
+    void    start();
+    void    stop();
+    void    post(const std::function<void(World&)>& command);
+
+    bool    update();
+    const WorldSnapshot& getSnapshot()          { return snapshots.getFront(); }
+    bool    isRunning()                         { return running.load(std::memory_order_relaxed); }
+};
+
+#endif // !__SIMULATION_THREAD_H
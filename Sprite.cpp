@@ -1,18 +1,44 @@
 #include "Sprite.h"
 #include "functions.h"
+#include "ColliderCache.h"
+#include "GLState.h"
+#include "RenderQueue.h"
+#include "SpriteBatch.h"
+#include "TextureAtlas.h"
+#include "TextureCache.h"
 
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
+#include <cmath>
+
+#define DEG_TO_RAD 0.01745329252f
+
+
+TextureCache*  Sprite::defaultTextureCache  = nullptr;
+ColliderCache* Sprite::defaultColliderCache = nullptr;
+
+
+/**
+ *  Tests two rotated quads, given by their transforms and half sizes, for a separating axis
+ */
+static bool quadsOverlap(const Transform2D& a, float halfXA, float halfYA, const Transform2D& b, float halfXB, float halfYB) {
+    Vec2 axes[4]  = { Vec2(a.c, a.s), Vec2(-a.s, a.c), Vec2(b.c, b.s), Vec2(-b.s, b.c) };
+    Vec2 distance = Vec2(b.x - a.x, b.y - a.y);
+    for (const Vec2& axis : axes) {
+        float radiusA = halfXA * std::fabs(dot(axes[0], axis)) + halfYA * std::fabs(dot(axes[1], axis)),
+              radiusB = halfXB * std::fabs(dot(axes[2], axis)) + halfYB * std::fabs(dot(axes[3], axis));
+        if (std::fabs(dot(distance, axis)) > radiusA + radiusB) return false;
+    }
+    return true;
+}
 
 
 /**
- *  Deconstructor
+ *  Deconstructor. The shader is shared, so it's left to whoever created it.
  */
 Sprite::~Sprite() {
-    glDeleteProgram(shader);
     CleanVAO(vao, &ebo);
+    releaseTexture();
 
+    delete spritesheet;
     delete vertices;
     delete indices;
 }
@@ -21,6 +47,7 @@ Sprite::~Sprite() {
 /**
 *   Initializes a new sprite with the given spritesheet and other variables
 *   @param spritesheet_filepath - Global filepath to the texture of the sprite
+*   @param program - The sprite shader, with its uniform locations looked up at link time
 *   @param texRect - The bounds of the rectangle which data in the image is sampled from
 *   @param spriteRect - The dimensions of the spritesheet
 *   @param position_X - The x-position of the sprite
@@ -29,24 +56,26 @@ Sprite::~Sprite() {
 *   @param size_Y - The height of the sprite (0-2)
 *   @param angle - The angle of the sprite (0-2pi)
 */
-Sprite::Sprite( char*       spritesheet_filepath,   GLuint   shader, 
+Sprite::Sprite( char*       spritesheet_filepath,   const ShaderProgram* program, 
                 floatRect   spritesheet_texRect,    intRect  spritesheet_spriteRect,
                 float       position_X /*= 0.f*/,   float    position_Y /*= 0.f*/, 
                 float       size_X     /*= 1.f*/,   float    size_Y     /*= 1.f*/, 
                 float       angle      /*= 0.f*/ ) {
 
     // Set physical sprite vars
-    this->shader = shader;
-    posX = position_X;
-    posY = position_Y;
+    this->shader = program->program;
+    transform = Transform2D(position_X, position_Y, angle * DEG_TO_RAD);
     sizeX = size_X;
     sizeY = size_Y;
     this->angle = angle;
-    anim_step = 0;
-        
-    // Initialize shaderprogram parameters
-    glUseProgram(shader);
-    glUniformMatrix4fv(glGetUniformLocation(shader, "u_TransformationMat"), 1, false, glm::value_ptr(glm::mat4(1)));
+    spritesheet = new SpriteSheet();
+    spritesheet->anim_step = 0;
+
+    // Initialize shaderprogram parameters. The program is shared, so they're all sent in draw().
+    transformLoc = program->getUniform("u_TransformationMat");
+    texRectLoc   = program->getUniform("u_TexRect");
+    sheetGridLoc = program->getUniform("u_SheetGrid");
+    frameLoc     = program->getUniform("u_Frame");
 
     // Initialize spritesheet
     init_spritesheet(spritesheet_filepath, spritesheet_texRect, spritesheet_spriteRect);
@@ -54,61 +83,39 @@ Sprite::Sprite( char*       spritesheet_filepath,   GLuint   shader,
 
 
 /**
-  * Sets the animation step and updates the sprite's texture
+  * Sets the animation step.
+  * The texture coordinates are worked out in the vertex shader, so nothing is uploaded
+  * here; draw() sends the step along with the sprite.
   * @param step - The animationstep
   */
 void Sprite::setAnimationStep(int step) {
-    // Get the width and height of the spritesheet
-    int     sw = spritesheet_spriteRect.x1 - spritesheet_spriteRect.x0,
-            sh = spritesheet_spriteRect.y1 - spritesheet_spriteRect.y0;
-
-    // Get the width and height of the texture rectangle
-    float   tw = spritesheet_texRect.x1 - spritesheet_texRect.x0,
-            th = spritesheet_texRect.y1 - spritesheet_texRect.y0;
-
-    // Get anim_step
-    anim_step = step % (sw * sh);
-
-    // Find x and y of the current tile on the spritesheet
-    int     sx = spritesheet_spriteRect.x0 + anim_step % sw,
-            sy = spritesheet_spriteRect.y0 + floor(anim_step / sw);
-
-    // Translate those to x and y on the texture rectangle
-    float   tx = spritesheet_texRect.x0 + (float)sx/(float)sw*tw,
-            ty = spritesheet_texRect.y0 + (float)sy/(float)sh*th;
-
-    // Using openGL's coordinate-system would mean that the bottom-left tile of the spritesheet
-    // would be the first animation step. This code flips the tiles so that the top-left tile
-    // is the first step instead.
-    ty = spritesheet_spriteRect.y1 - ty;
-
-
-    // Get the width and height of one sprite within the texture
-    float   tsw = tw/(float)sw,
-            tsh = th/(float)sh;
-
-    // Update the texture-coordinates for the buffer with the new rectangle's boundries
-    (*vertices)[2 + 4*0 + 0] = tx + tsw;    // Top right
-    (*vertices)[2 + 4*0 + 1] = ty + tsh;
-    (*vertices)[2 + 4*1 + 0] = tx + tsw;    // Bottom right
-    (*vertices)[2 + 4*1 + 1] = ty;
-    (*vertices)[2 + 4*2 + 0] = tx;          // Bottom left
-    (*vertices)[2 + 4*2 + 1] = ty;
-    (*vertices)[2 + 4*3 + 0] = tx;          // Top left
-    (*vertices)[2 + 4*3 + 1] = ty + tsh;
-
-    // Update buffer data
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof_v(*vertices), &(*vertices)[0], GL_STATIC_DRAW);
-    //glBindBuffer(GL_ARRAY_BUFFER, 0);
+    const intRect& spriteRect = spritesheet->spriteRect;
+    int steps = (spriteRect.x1 - spriteRect.x0) * (spriteRect.y1 - spriteRect.y0);
+    spritesheet->anim_step = steps > 0 ? step % steps : 0;
 }
 
 
 /**
- *  Sets the base transformations of the vbo
+ *  Gets the animation grid of the spritesheet, as read by the sprite shaders
+ *  @param grid - Output first column, first row, number of columns and number of rows
+ */
+void Sprite::getSheetGrid(int grid[4]) {
+    const intRect& spriteRect = spritesheet->spriteRect;
+    grid[0] = spriteRect.x0;
+    grid[1] = spriteRect.y0;
+    grid[2] = spriteRect.x1 - spriteRect.x0;
+    grid[3] = spriteRect.y1 - spriteRect.y0;
+}
+
+
+/**
+ *  Sets the base transformations of the vbo. The sprite's own transform is applied on top
+ *  of these by the shader, so the quad is normally left unrotated.
  *  @param ...
+ *  @param rotation - A cached rotation (its cosine and sine) to bake into the quad, e.g. transform
  */
-void Sprite::init_vbo( float posX /*= 0.f*/, float posY /*= 0.f*/, float sizeX /*= 1.f*/, float sizeY /*= 1.f*/, float angle /*= 0.f*/) {
+void Sprite::init_vbo( float posX /*= 0.f*/, float posY /*= 0.f*/, float sizeX /*= 1.f*/, float sizeY /*= 1.f*/,
+                       const Transform2D& rotation /*= Transform2D()*/) {
     // Get the points in the quad without any rotation and their centre
     float   topRx = posX + sizeX / 2.f,
             topRy = posY + sizeY / 2.f,
@@ -121,11 +128,11 @@ void Sprite::init_vbo( float posX /*= 0.f*/, float posY /*= 0.f*/, float sizeX /
             centrex = (topRx + botRx + botLx + topLx) / 4.f,
             centrey = (topRy + botRy + botLy + topLy) / 4.f;
 
-    // Rotate them
-    rotate_point(topRx, topRy, angle, centrex, centrey);
-    rotate_point(botRx, botRy, angle, centrex, centrey);
-    rotate_point(botLx, botLy, angle, centrex, centrey);
-    rotate_point(topLx, topLy, angle, centrex, centrey);
+    // Rotate them by the cached cosine and sine, shared by all four corners
+    rotate_point(topRx, topRy, rotation.c, rotation.s, centrex, centrey);
+    rotate_point(botRx, botRy, rotation.c, rotation.s, centrex, centrey);
+    rotate_point(botLx, botLy, rotation.c, rotation.s, centrex, centrey);
+    rotate_point(topLx, topLy, rotation.c, rotation.s, centrex, centrey);
 
     // Update the vertices with the new coordinates (and sizes)
     (*vertices)[4*0 + 0] = topRx; // top right
@@ -137,29 +144,10 @@ void Sprite::init_vbo( float posX /*= 0.f*/, float posY /*= 0.f*/, float sizeX /
     (*vertices)[4*3 + 0] = topLx; // top left
     (*vertices)[4*3 + 1] = topLy;
 
-    // Update buffer data
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof_v(*vertices), &(*vertices)[0], GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-}
-
-
-/**
- *  Updates the sprite with its transformations (pos, angle, etc) using its shaderprogram
- */
-void Sprite::update_transformation() {
-    // Enable the right shaderprogram
-    glUseProgram(shader);
-
-    // Create transformation
-    glm::mat4 translation    = glm::translate(glm::mat4(1), glm::vec3(posX, posY, 0.f));//posX, posY, 0.f));
-    glm::mat4 rotation       = glm::rotate   (glm::mat4(1), glm::radians(angle), glm::vec3(0, 0, 1));
-    glm::mat4 scale          = glm::scale    (glm::mat4(1), glm::vec3(sizeX, sizeY, 1.f));
-    glm::mat4 transformation = translation * rotation * scale;
-
-    // ...And lastly, get uniform position and send the data to the shader
-    GLuint transformationmat = glGetUniformLocation(shader, "u_TransformationMat");
-    glUniformMatrix4fv(transformationmat, 1, false, glm::value_ptr(transformation));
+    // Update buffer data in place, the storage was allocated in init_spritesheet()
+    GLState::bindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices->size() * sizeof(float), &(*vertices)[0]);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 
@@ -173,65 +161,154 @@ void Sprite::update_transformation() {
  *  @param angle - The angle of the sprite (0-2pi)
  */
 void Sprite::setTransformation(float x/*=NULL*/, float y/*=NULL*/, float width/*=NULL*/, float height/*=NULL*/, float angle/*=NULL*/) {
+    // Set angle
+    this->angle = (angle == NULL ? this->angle : angle);
+
     // Set posX and posY
-    posX = (x == NULL ? posX : x);
-    posY = (y == NULL ? posY : y);
+    transform = Transform2D(x == NULL ? transform.x : x,
+                            y == NULL ? transform.y : y,
+                            this->angle * DEG_TO_RAD);
 
     // Set size
     sizeX = (width == NULL ? sizeX : width);
     sizeY = (height == NULL ? sizeX : height);
-
-    // Set angle
-    this->angle = (angle == NULL ? this->angle : angle);
-
-    // Update
-    update_transformation();
 }
 
 
 /**
- *  Sets the position of the sprite and updates it
+ *  Sets the position of the sprite
  *  @param x - The x-position of the sprite
  *  @param y - The y-position of the sprite
- *  @see Sprite::update_transformation()
  */
 void Sprite::setPosition(float x, float y) {
     // Set posX and posY
-    posX = x;
-    posY = y;
-
-    // Update
-    update_transformation();
+    transform.x = x;
+    transform.y = y;
 }
 
 
 /**
- *  Sets the size of the sprite and updates it
+ *  Sets the size of the sprite
  *  @param width - The width of the sprite (0-2)
  *  @param height - The height of the sprite (0-2)
- *  @see Sprite::update_transformation()
  */
 void Sprite::setSize(float width, float height) {
     // Set posX and posY
     sizeX = width;
     sizeY = height;
-
-    // Update
-    update_transformation();
 }
 
 
 /**
- *  Sets the angle of the sprite and updates it
+ *  Sets the angle of the sprite
  *  @param angle - The angle of the sprite
- *  @see Sprite::update_transformation()
  */
 void Sprite::setAngle(float angle) {
     // Set angle
     this->angle = angle;
+    transform.c = cos(angle * DEG_TO_RAD);
+    transform.s = sin(angle * DEG_TO_RAD);
+}
+
+
+/**
+ *  Sets the position and rotation of the sprite, e.g. from a physics body
+ *  @param transform - The new transform
+ */
+void Sprite::setTransform(const Transform2D& transform) {
+    this->transform = transform;
+    angle = transform.getAngle() / DEG_TO_RAD;
+}
+
+
+/**
+ *  Lets go of the sprite's texture: back to the cache it came from, or deleted if the sprite
+ *  loaded it itself. Textures of an atlas belong to the atlas and are left alone.
+ */
+void Sprite::releaseTexture() {
+    if (ownsTexture) {
+        if (textureCache) textureCache->release(tex);
+        else              GLState::deleteTextures(1, &tex);
+    }
+    ownsTexture  = false;
+    textureCache = nullptr;
+}
+
+
+/**
+ *  Sets the cache that sprites created from now on load their images through
+ *  @param cache - The cache, or null to have each sprite load its own copy
+ */
+void Sprite::setTextureCache(TextureCache* cache) {
+    defaultTextureCache = cache;
+}
+
+
+/**
+ *  Sets the cache that sprites created from now on get their pixel masks from
+ *  @param cache - The cache, or null to have overlaps() only test the sprites' quads
+ */
+void Sprite::setColliderCache(ColliderCache* cache) {
+    defaultColliderCache = cache;
+}
+
+
+/**
+ *  Gets the pixel mask of the sprite's current animation step, looked up once per step
+ *  @return The mask, null without a collider cache or if the image couldn't be loaded
+ */
+const PixelMask* Sprite::getPixelMask() {
+    if (pixelMaskStep != spritesheet->anim_step) {
+        pixelMaskStep = spritesheet->anim_step;
+        pixelMask     = colliderCache ? colliderCache->getPixelMask(spritesheet->filepath, spritesheet->sourceRect,
+                                                                    spritesheet->spriteRect, pixelMaskStep)
+                                      : nullptr;
+    }
+    return pixelMask;
+}
+
+
+/**
+ *  Tests whether the sprite touches another one. The quads are tested first, with separating
+ *  axes; if they overlap, unrotated sprites drawn at the same pixel scale are then tested pixel
+ *  by pixel with the masks of their current frames. Other sprites stop at the quad test.
+ *  @param other - The other sprite
+ */
+bool Sprite::overlaps(Sprite& other) {
+    if (!quadsOverlap(transform, sizeX / 2.f, sizeY / 2.f, other.transform, other.sizeX / 2.f, other.sizeY / 2.f))
+        return false;
+
+    const PixelMask* mask      = getPixelMask();
+    const PixelMask* otherMask = other.getPixelMask();
+    if (!mask || !otherMask || transform.s != 0.f || transform.c < 0.f || other.transform.s != 0.f || other.transform.c < 0.f)
+        return true;
+
+    float scaleX = mask->getWidth()  / sizeX,       // Pixels per unit
+          scaleY = mask->getHeight() / sizeY;
+    if (std::fabs(otherMask->getWidth()  / other.sizeX - scaleX) > 0.01f * scaleX ||
+        std::fabs(otherMask->getHeight() / other.sizeY - scaleY) > 0.01f * scaleY)
+        return true;
+
+    int offsetX = (int)std::lround(((other.transform.x - other.sizeX / 2.f) - (transform.x - sizeX / 2.f)) * scaleX),
+        offsetY = (int)std::lround(((other.transform.y - other.sizeY / 2.f) - (transform.y - sizeY / 2.f)) * scaleY);
+    return mask->overlaps(*otherMask, offsetX, offsetY);
+}
+
 
-    // Update
-    update_transformation();
+/**
+ *  Switches the sprite to its image in an atlas, so it can be batched with sprites of other images
+ *  @param atlas - An atlas the spritesheet's file was added to and built
+ *  @return Whether the spritesheet was found in the atlas
+ */
+bool Sprite::useAtlas(TextureAtlas& atlas) {
+    AtlasEntry entry;
+    if (!atlas.find(spritesheet->filepath, entry)) return false;
+
+    // The sprite's own copy of the image isn't needed anymore
+    releaseTexture();
+    tex = atlas.getTexture(entry.page);
+    spritesheet->texRect = atlas.remap(entry, spritesheet->texRect);
+    return true;
 }
 
 
@@ -243,9 +320,10 @@ void Sprite::setAngle(float angle) {
 */
 void Sprite::init_spritesheet( char* filepath, floatRect texRect, intRect spriteRect) {
     // Set vars
-    spritesheet_filepath    = filepath;
-    spritesheet_texRect     = texRect;
-    spritesheet_spriteRect  = spriteRect;
+    spritesheet->filepath   = filepath;
+    spritesheet->texRect    = texRect;
+    spritesheet->sourceRect = texRect;
+    spritesheet->spriteRect = spriteRect;
 
     // Set up data for the square of the sprite
     vertices = new std::vector<float>{
@@ -267,13 +345,13 @@ void Sprite::init_spritesheet( char* filepath, floatRect texRect, intRect sprite
     glGenBuffers(1, &vbo);
     glGenBuffers(1, &ebo);
 
-    glBindVertexArray(vao);
+    GLState::bindVertexArray(vao);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof_v(*vertices), &(*vertices)[0], GL_STATIC_DRAW);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices->size() * sizeof(float), &(*vertices)[0], GL_DYNAMIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof_v(*indices), &(*indices)[0], GL_STATIC_DRAW);
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices->size() * sizeof(unsigned int), &(*indices)[0], GL_STATIC_DRAW);
 
     // Position attribute
     glEnableVertexAttribArray(0);
@@ -283,35 +361,19 @@ void Sprite::init_spritesheet( char* filepath, floatRect texRect, intRect sprite
     glEnableVertexAttribArray(2);
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
 
-    // Generate texture
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-
-    // set the texture wrapping parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    // set texture filtering parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    // Load the spritesheet's image
-    stbi_set_flip_vertically_on_load(true);
-    int texWidth, texHeight, nrChannels;
-    unsigned char* data = stbi_load(spritesheet_filepath, &texWidth, &texHeight, &nrChannels, 0);
-    if (!data) // TODO: Find a better way to handle errors like this
-        std::cout << "Texture load failed." << '\n';
-
-    // Set the texture's data to the loaded image's data, generate bitmap and free memory
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texWidth, texHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    stbi_image_free(data);
+    // Load the spritesheet's image, shared with other sprites of the same file when there is a cache
+    textureCache  = defaultTextureCache;
+    ownsTexture   = true;
+    colliderCache = defaultColliderCache;
+    pixelMask     = nullptr;
+    pixelMaskStep = -1;
+    tex = textureCache ? textureCache->acquire(spritesheet->filepath)
+                       : TextureCache::load(spritesheet->filepath);
 
     // Initialize vbo, vao, ebo and the shader
     
-    setAnimationStep(anim_step);
+    setAnimationStep(spritesheet->anim_step);
     init_vbo();
-    update_transformation();
 }
 
 
@@ -319,13 +381,50 @@ void Sprite::init_spritesheet( char* filepath, floatRect texRect, intRect sprite
  *  Draws the sprite onto the screen
  */
 void Sprite::draw() {
-    glUseProgram(shader);
+    GLState::useProgram(shader);
+
+    // The sprite's own transformation (translation * rotation * scale, packed as a 3x2 matrix),
+    // sent every draw as the program is shared with other sprites
+    float transformation[6];
+    toMat3x2(transform, sizeX, sizeY, transformation);
+    glUniformMatrix3x2fv(transformLoc, 1, GL_FALSE, transformation);
+
+    // The spritesheet and animation step, which the shader turns into texture coordinates
+    const floatRect& texRect = spritesheet->texRect;
+    int grid[4];
+    getSheetGrid(grid);
+    glUniform4f(texRectLoc, texRect.x0, texRect.y0, texRect.x1, texRect.y1);
+    glUniform4i(sheetGridLoc, grid[0], grid[1], grid[2], grid[3]);
+    glUniform1i(frameLoc, spritesheet->anim_step);
+
+    GLState::activeTexture(GL_TEXTURE0);
+    GLState::bindTexture(GL_TEXTURE_2D, tex);
+
+    GLState::bindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+}
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, tex);
 
-    glBindVertexArray(vao);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+/**
+ *  Adds the sprite to a batch instead of drawing it on its own
+ *  @param batch - The batch, which draws all its sprites in SpriteBatch::draw()
+ */
+void Sprite::draw(SpriteBatch& batch) {
+    int grid[4];
+    getSheetGrid(grid);
+    batch.add(tex, transform, sizeX, sizeY, spritesheet->texRect, grid, spritesheet->anim_step);
+}
+
+
+/**
+ *  Submits the sprite to a render queue, drawn with the queue's batch shader
+ *  @param layer - Layers are drawn in increasing order
+ *  @param depth - Order within the layer among sprites sharing the texture, lowest first
+ */
+void Sprite::draw(RenderQueue& queue, int layer, float depth /*= 0.f*/) {
+    int grid[4];
+    getSheetGrid(grid);
+    queue.submit(layer, 0, tex, depth, transform, sizeX, sizeY, spritesheet->texRect, grid, spritesheet->anim_step);
 }
 
 
@@ -345,13 +444,13 @@ int Sprite::sizeof_v(std::vector<T> v) { return sizeof(std::vector<T>) + sizeof(
 
 /**
  *  Rotates a point around an origin
+ *  @param c - Cosine of the angle
+ *  @param s - Sine of the angle
  */
-void Sprite::rotate_point(float& px, float& py, float angle, float ox, float oy) {
+void Sprite::rotate_point(float& px, float& py, float c, float s, float ox, float oy) {
     px -= ox; py -= oy;
 
-    float   s = sin(angle),
-            c = cos(angle),
-            xn = px * c - py * s,
+    float   xn = px * c - py * s,
             yn = px * s + py * c;
 
     px = xn + ox;
@@ -3,12 +3,21 @@
 
 #include <iostream>
 #include <vector>
+#include "ShaderRegistry.h"
 #include "stb_image.h"
+#include "Transform2D.h"
 
 
 #ifndef SPRITE_H
 #define SPRITE_H
 
+class ColliderCache;
+class PixelMask;
+class RenderQueue;
+class SpriteBatch;
+class TextureAtlas;
+class TextureCache;
+
 
 /**
  *  A storageclass for integer rectangles
@@ -34,38 +43,65 @@ public:
 };
 
 
+/**
+ *  The spritesheet data of a sprite.
+ *  The animation step is resolved against it in the vertex shader, so changing
+ *  step only changes anim_step.
+ */
+struct SpriteSheet {
+    char*           filepath;               // (Absolute) filepath of the spritesheet
+    floatRect       texRect;                // The rectangle to sample data from within the image file
+    floatRect       sourceRect;             // texRect in the image file itself, which an atlas doesn't change
+    intRect         spriteRect;             // The spritesheet's dimensions
+    int             anim_step;              // Which step of its animation the sprite is in
+};
+
+
 /**
  *  A class for drawing images onto the screen
  */
 class Sprite {
 private:
-    float           posX,                   // X-position of the sprite on the screen
-                    posY,                   // Y-position of the sprite on the screen
-                    sizeX,                  // How wide the sprite is on the screen (2=full width)
+    // Transformation, touched every time the sprite moves
+    Transform2D     transform;              // Position and rotation (cos/sin) of the sprite on the screen
+    float           sizeX,                  // How wide the sprite is on the screen (2=full width)
                     sizeY,                  // how high the sprite is on the screen (2=full height)
                     angle;                  // Angle of the sprite in degrees (anti-clockwise)
 
-    char*           spritesheet_filepath;   // (Absolute) filepath of the spritesheet
-    floatRect       spritesheet_texRect;    // The rectangle to sample data from within the image file
-    intRect         spritesheet_spriteRect; // The spritesheet's dimensions
-
-    int             anim_step;              // Which step of its animation the sprite is in
-
+    // GL handles, touched every draw
+    GLuint          vao, vbo, ebo, tex, shader;
+    GLint           transformLoc,           // Location of u_TransformationMat in the shader
+                    texRectLoc,             // Location of u_TexRect
+                    sheetGridLoc,           // Location of u_SheetGrid
+                    frameLoc;               // Location of u_Frame
+
+    // Cold data, only touched when the sprite is (re)initialized or animated
+    SpriteSheet*                spritesheet;
+    TextureCache*               textureCache;   // Where tex came from, null if the sprite loaded it
+    bool                        ownsTexture;    // False when tex belongs to an atlas
+    ColliderCache*              colliderCache;  // Where pixel masks come from, null for box tests only
+    const PixelMask*            pixelMask;      // Of the frame pixelMaskStep
+    int                         pixelMaskStep;  // -1 until a mask is looked up
     std::vector<float>*         vertices;
     std::vector<unsigned int>*  indices;
-    GLuint                      vao, vbo, ebo, tex, shader;
+
+    static TextureCache*        defaultTextureCache;    // Used by sprites created from now on
+    static ColliderCache*       defaultColliderCache;
+
+    void releaseTexture();
 
 
 public:
-    float           getPositionX()  { return posX; }
-    float           getPositionY()  { return posY; }
+    float           getPositionX()  { return transform.x; }
+    float           getPositionY()  { return transform.y; }
     float           getWidth()      { return sizeX; }
     float           getHeight()     { return sizeY; }
     float           getAngle()      { return angle; }
-    int             getAnimStep()   { return anim_step; }
+    int             getAnimStep()   { return spritesheet->anim_step; }
 
-    Sprite () {}
-    Sprite( char*       spritesheet_filepath,   GLuint   shader, 
+    Sprite () : tex(0), spritesheet(nullptr), textureCache(nullptr), ownsTexture(false), colliderCache(nullptr),
+                pixelMask(nullptr), pixelMaskStep(-1), vertices(nullptr), indices(nullptr) {}
+    Sprite( char*       spritesheet_filepath,   const ShaderProgram* program, 
             floatRect   spritesheet_texRect,    intRect  spritesheet_spriteRect,
             float       position_X = 0.f,       float    position_Y = 0.f, 
             float       size_X     = 1.f,       float    size_Y     = 1.f, 
@@ -73,7 +109,7 @@ public:
     
     void init_vbo( float posX  = 0.f, float posY  = 0.f,
                    float sizeX = 1.f, float sizeY = 1.f, 
-                   float angle = 0.f );
+                   const Transform2D& rotation = Transform2D() );
 
     void init_spritesheet(char* filepath, floatRect texRect, intRect spriteRect);
     
@@ -84,13 +120,23 @@ public:
     void setPosition        ( float x, float y );
     void setSize            ( float width, float height );
     void setAngle           ( float angle );
-    void update_transformation();
+    void setTransform       ( const Transform2D& transform );
+    bool useAtlas           ( TextureAtlas& atlas );
+
+    static void setTextureCache(TextureCache* cache);
+    static void setColliderCache(ColliderCache* cache);
+
+    const PixelMask* getPixelMask();
+    bool overlaps(Sprite& other);
 
     void draw();
+    void draw(SpriteBatch& batch);
+    void draw(RenderQueue& queue, int layer, float depth = 0.f);
+    void getSheetGrid(int grid[4]);
 
     template <typename T>
     int  sizeof_v(std::vector<T> v);
-    void rotate_point(float& px, float& py, float angle, float ox, float oy);
+    void rotate_point(float& px, float& py, float c, float s, float ox, float oy);
 };
 
 
@@ -0,0 +1,240 @@
+#include "SpriteBatch.h"
+#include "GLState.h"
+
+#include <cstddef>
+#include <cstring>
+
+
+/**
+ *  Creates the shared quad and an instance buffer
+ *  @param program - A shader program compiled from spriteBatchShader.h
+ *  @param capacity - How many instances to make room for up front, it grows when needed
+ */
+SpriteBatch::SpriteBatch(const ShaderProgram* program, size_t capacity /*= 1024*/)
+    : instanceBuffer(GL_ARRAY_BUFFER, (capacity > 0 ? capacity : 1) * sizeof(SpriteInstance)) {
+    shader         = program->program;
+    lastGroup      = 0;
+    drawCalls      = 0;
+
+    // A unit quad centred on the origin, scaled by each instance's transform
+    float quad[] = {
+        // Positions        // Texture coords
+        0.5f,   0.5f,       1.0f, 1.0f, // top right        0
+        0.5f,   -0.5f,      1.0f, 0.0f, // bottom right     1
+        -0.5f,  -0.5f,      0.0f, 0.0f, // bottom left      2
+        -0.5f,  0.5f,       0.0f, 1.0f  // top left         3
+    };
+    unsigned int indices[] = {
+        0, 1, 3,
+        1, 2, 3
+    };
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &quadVbo);
+    glGenBuffers(1, &ebo);
+
+    GLState::bindVertexArray(vao);
+
+    GLState::bindBuffer(GL_ARRAY_BUFFER, quadVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    // Instance attributes advance once per sprite instead of once per vertex
+    GLState::bindBuffer(GL_ARRAY_BUFFER, instanceBuffer.getBuffer());
+    for (GLuint attribute = 2; attribute <= 7; attribute++) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+    setInstanceOffset(0);
+
+    GLState::bindVertexArray(0);
+
+    GLState::useProgram(shader);
+    glUniform1i(program->getUniform("ourTexture"), 0);
+}
+
+
+SpriteBatch::~SpriteBatch() {
+    GLState::deleteBuffers(1, &quadVbo);
+    GLState::deleteBuffers(1, &ebo);
+    GLState::deleteVertexArrays(1, &vao);
+}
+
+
+/**
+ *  Points the instance attributes at an instance in the buffer.
+ *  GL 3.3 has no base instance, so this is how each texture's range is selected.
+ *  The vao and the instance buffer must be bound.
+ *  @param first - Index of the first instance to draw
+ */
+void SpriteBatch::setInstanceOffset(size_t first) {
+    size_t base = first * sizeof(SpriteInstance);
+    glVertexAttribPointer(2, 4, GL_FLOAT,         GL_FALSE, sizeof(SpriteInstance), (void*)(base + offsetof(SpriteInstance, basis)));
+    glVertexAttribPointer(3, 2, GL_FLOAT,         GL_FALSE, sizeof(SpriteInstance), (void*)(base + offsetof(SpriteInstance, offset)));
+    glVertexAttribPointer(4, 4, GL_FLOAT,         GL_FALSE, sizeof(SpriteInstance), (void*)(base + offsetof(SpriteInstance, texRect)));
+    glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(SpriteInstance), (void*)(base + offsetof(SpriteInstance, tint)));
+    glVertexAttribIPointer(6, 4, GL_SHORT,                  sizeof(SpriteInstance), (void*)(base + offsetof(SpriteInstance, sheetGrid)));
+    glVertexAttribIPointer(7, 1, GL_UNSIGNED_INT,           sizeof(SpriteInstance), (void*)(base + offsetof(SpriteInstance, frame)));
+}
+
+
+/**
+ *  Gets the group of a texture, adding it if it's new
+ */
+SpriteBatch::TextureGroup& SpriteBatch::getGroup(GLuint texture) {
+    if (lastGroup < groups.size() && groups[lastGroup].texture == texture)
+        return groups[lastGroup];
+
+    for (lastGroup = 0; lastGroup < groups.size(); lastGroup++) {
+        if (groups[lastGroup].texture == texture)
+            return groups[lastGroup];
+    }
+
+    groups.push_back(TextureGroup());
+    groups.back().texture = texture;
+    return groups.back();
+}
+
+
+/**
+ *  Starts a new frame, forgetting the sprites of the previous one.
+ *  The groups keep their memory, so adding the same sprites again doesn't allocate.
+ */
+void SpriteBatch::begin() {
+    for (TextureGroup& group : groups)
+        group.instances.clear();
+}
+
+
+/**
+ *  Adds a sprite to be drawn
+ *  @param texture - The sprite's texture
+ *  @param transform - Position and rotation of the sprite's centre
+ *  @param sizeX - How wide the sprite is on the screen (2=full width)
+ *  @param sizeY - How high the sprite is on the screen (2=full height)
+ *  @param texRect - The spritesheet's rectangle in the texture (or the whole image to draw)
+ *  @param sheetGrid - First column, first row, columns and rows of the animation (null = one tile)
+ *  @param frame - The animation step
+ *  @param tint - Colour the texture is multiplied with (0xRRGGBBAA)
+ */
+void SpriteBatch::add(GLuint texture, const Transform2D& transform, float sizeX, float sizeY,
+                      const floatRect& texRect, const int sheetGrid[4] /*= nullptr*/, int frame /*= 0*/,
+                      uint32_t tint /*= 0xFFFFFFFF*/) {
+    getGroup(texture).instances.push_back(makeInstance(transform, sizeX, sizeY, texRect, sheetGrid, frame, tint));
+}
+
+
+/**
+ *  Packs a sprite into the instance layout of the batch shader (see add() for the parameters)
+ */
+SpriteInstance SpriteBatch::makeInstance(const Transform2D& transform, float sizeX, float sizeY,
+                                         const floatRect& texRect, const int sheetGrid[4] /*= nullptr*/,
+                                         int frame /*= 0*/, uint32_t tint /*= 0xFFFFFFFF*/) {
+    float matrix[6];
+    toMat3x2(transform, sizeX, sizeY, matrix);
+
+    SpriteInstance instance;
+    instance.basis[0]   = matrix[0];
+    instance.basis[1]   = matrix[1];
+    instance.basis[2]   = matrix[2];
+    instance.basis[3]   = matrix[3];
+    instance.offset[0]  = matrix[4];
+    instance.offset[1]  = matrix[5];
+    instance.texRect[0] = texRect.x0;
+    instance.texRect[1] = texRect.y0;
+    instance.texRect[2] = texRect.x1;
+    instance.texRect[3] = texRect.y1;
+    instance.tint[0]    = (uint8_t)(tint >> 24);
+    instance.tint[1]    = (uint8_t)(tint >> 16);
+    instance.tint[2]    = (uint8_t)(tint >> 8);
+    instance.tint[3]    = (uint8_t)tint;
+    for (int i = 0; i < 4; i++)
+        instance.sheetGrid[i] = (int16_t)(sheetGrid ? sheetGrid[i] : (i < 2 ? 0 : 1));
+    instance.frame      = (uint32_t)frame;
+    return instance;
+}
+
+
+/**
+ *  Uploads all sprites added since begin() and draws them, one draw call per texture
+ */
+void SpriteBatch::draw() {
+    drawCalls = 0;
+
+    size_t count = 0;
+    for (const TextureGroup& group : groups)
+        count += group.instances.size();
+    if (count == 0) return;
+
+    // Write the groups back to back into this frame's region of the instance buffer
+    SpriteInstance* out = (SpriteInstance*)instanceBuffer.map(count * sizeof(SpriteInstance));
+    size_t offset = 0;
+    groupRuns.clear();
+    for (const TextureGroup& group : groups) {
+        if (group.instances.empty()) continue;
+        memcpy(out + offset, &group.instances[0], group.instances.size() * sizeof(SpriteInstance));
+        offset += group.instances.size();
+
+        SpriteRun run = { shader, group.texture, group.instances.size() };
+        groupRuns.push_back(run);
+    }
+    size_t first = instanceBuffer.unmap() / sizeof(SpriteInstance);
+
+    drawRuns(first, &groupRuns[0], groupRuns.size());
+}
+
+
+/**
+ *  Uploads instances that are already in draw order and draws them, one draw call per run.
+ *  The sprites added since begin() aren't touched.
+ *  @param instances - The instances of all runs, back to back
+ *  @param runs - How many instances are drawn with which shader and texture, in order
+ *  @param runCount - The number of runs
+ */
+void SpriteBatch::draw(const SpriteInstance* instances, const SpriteRun* runs, size_t runCount) {
+    drawCalls = 0;
+
+    size_t count = 0;
+    for (size_t i = 0; i < runCount; i++)
+        count += runs[i].count;
+    if (count == 0) return;
+
+    void* out = instanceBuffer.map(count * sizeof(SpriteInstance));
+    memcpy(out, instances, count * sizeof(SpriteInstance));
+    size_t first = instanceBuffer.unmap() / sizeof(SpriteInstance);
+
+    drawRuns(first, runs, runCount);
+}
+
+
+/**
+ *  Issues the draw calls of runs whose instances were just written to the instance buffer
+ *  @param first - Index of the first run's first instance in the buffer
+ */
+void SpriteBatch::drawRuns(size_t first, const SpriteRun* runs, size_t runCount) {
+    GLState::bindVertexArray(vao);
+    GLState::activeTexture(GL_TEXTURE0);
+
+    // The tracker skips the program and texture binds that repeat between runs
+    size_t offset = 0;
+    for (size_t i = 0; i < runCount; i++) {
+        if (runs[i].count == 0) continue;
+
+        GLState::useProgram(runs[i].shader);
+        GLState::bindTexture(GL_TEXTURE_2D, runs[i].texture);
+        setInstanceOffset(first + offset);
+        glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, (GLsizei)runs[i].count);
+
+        offset += runs[i].count;
+        drawCalls++;
+    }
+
+    GLState::bindVertexArray(0);
+    instanceBuffer.fence();
+}
@@ -0,0 +1,85 @@
+#ifndef __SPRITE_BATCH_H
+#define __SPRITE_BATCH_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+#include "Sprite.h"
+#include "StreamBuffer.h"
+#include "Transform2D.h"
+
+
+/**
+ *  The per-instance data of one sprite, as read by the batch shader
+ */
+struct SpriteInstance {
+    float       basis[4];               // First two columns of the 3x2 transform (rotation * scale)
+    float       offset[2];              // Last column of the 3x2 transform (translation)
+    float       texRect[4];             // The spritesheet's rectangle in the texture
+    uint8_t     tint[4];                // RGBA multiplied with the texture
+    int16_t     sheetGrid[4];           // First column and row of the animation, columns and rows
+    uint32_t    frame;                  // Animation step, resolved against sheetGrid in the shader
+};
+
+
+/**
+ *  Consecutive instances drawn with the same shader and texture
+ */
+struct SpriteRun {
+    GLuint      shader;                 // Must use the batch shader's attribute layout
+    GLuint      texture;
+    size_t      count;
+};
+
+
+/**
+ *  Draws many sprites with one instanced draw call per texture.
+ *
+ *  All sprites share a single unit quad; everything that differs between them is streamed
+ *  into an instance buffer once per frame, written straight into persistently mapped
+ *  memory where the driver supports it (see StreamBuffer). Sprites are grouped by texture
+ *  as they are added, so the order between sprites of different textures isn't kept;
+ *  a RenderQueue sorts its sprites itself and hands them over as runs instead.
+ */
+class SpriteBatch {
+private:
+    /**
+     *  The sprites that are drawn with one texture
+     */
+    struct TextureGroup {
+        GLuint                      texture;
+        std::vector<SpriteInstance> instances;
+    };
+
+    GLuint                      vao, quadVbo, ebo, shader;
+    StreamBuffer                instanceBuffer;     // Per-instance data, rewritten every frame
+    std::vector<TextureGroup>   groups;
+    size_t                      lastGroup;          // Group of the previous add, usually the next one's too
+    std::vector<SpriteRun>      groupRuns;          // The groups as runs, kept to reuse the memory
+    int                         drawCalls;          // Draw calls issued by the last draw()
+
+    TextureGroup&   getGroup(GLuint texture);
+    void            setInstanceOffset(size_t first);
+    void            drawRuns(size_t first, const SpriteRun* runs, size_t runCount);
+
+public:
+    SpriteBatch(const ShaderProgram* program, size_t capacity = 1024);
+    ~SpriteBatch();
+
+    void    begin();
+    void    add(GLuint texture, const Transform2D& transform, float sizeX, float sizeY,
+                const floatRect& texRect, const int sheetGrid[4] = nullptr, int frame = 0,
+                uint32_t tint = 0xFFFFFFFF);
+    void    draw();
+    void    draw(const SpriteInstance* instances, const SpriteRun* runs, size_t runCount);
+
+    static SpriteInstance makeInstance(const Transform2D& transform, float sizeX, float sizeY,
+                                       const floatRect& texRect, const int sheetGrid[4] = nullptr,
+                                       int frame = 0, uint32_t tint = 0xFFFFFFFF);
+
+    GLuint  getShader()             { return shader; }
+    int     getDrawCalls()          { return drawCalls; }
+};
+
+#endif // !__SPRITE_BATCH_H
@@ -0,0 +1,56 @@
+#include "StaticTree.h"
+
+#include <algorithm>
+
+
+/**
+ *  Builds the tree, replacing what was there
+ *  @param boxes - The items' boxes, the items are their indices
+ *  @param count - Number of items
+ *  @param leafSize - Most items in a leaf
+ */
+void StaticTree::build(const AABB* boxes, int count, int leafSize /*= 2*/) {
+    nodes.clear();
+    items.resize(count);
+    if (count == 0) return;
+
+    std::vector<Vec2> centers(count);
+    for (int i = 0; i < count; i++) {
+        items[i]   = i;
+        centers[i] = 0.5f * (boxes[i].lower + boxes[i].upper);
+    }
+    nodes.reserve(2 * (count / std::max(leafSize, 1)) + 1);
+    build(boxes, centers, 0, count, std::max(leafSize, 1));
+}
+
+
+/**
+ *  Adds the node of items[begin..end) and, depth-first, its children
+ */
+void StaticTree::build(const AABB* boxes, const std::vector<Vec2>& centers, int begin, int end, int leafSize) {
+    int  node = (int)nodes.size();
+    AABB box  = boxes[items[begin]];
+    Vec2 low  = centers[items[begin]],
+         high = low;
+    for (int i = begin + 1; i < end; i++) {
+        box.lower = minVec(box.lower, boxes[items[i]].lower);
+        box.upper = maxVec(box.upper, boxes[items[i]].upper);
+        low       = minVec(low,  centers[items[i]]);
+        high      = maxVec(high, centers[items[i]]);
+    }
+    Node leaf = { box, begin, end - begin };
+    nodes.push_back(leaf);
+    if (end - begin <= leafSize) return;
+
+    // Split at the median centre along the axis the centres spread furthest on
+    int  middle = begin + (end - begin) / 2;
+    bool alongX = high.x - low.x >= high.y - low.y;
+    std::nth_element(items.begin() + begin, items.begin() + middle, items.begin() + end, [&](int a, int b) {
+        return alongX ? centers[a].x < centers[b].x : centers[a].y < centers[b].y;
+    });
+
+    nodes[node].count = 0;
+    build(boxes, centers, begin, middle, leafSize);
+    nodes[node].next  = (int)nodes.size();
+    build(boxes, centers, middle, end, leafSize);
+}
@@ -0,0 +1,65 @@
+#ifndef __STATIC_TREE_H
+#define __STATIC_TREE_H
+
+#include "Math2D.h"
+
+#include <vector>
+
+#define STATIC_TREE_MAX_DEPTH 64        // Deeper than a median split of any count of items gets
+
+
+/**
+ *  A bounding volume hierarchy over boxes that don't move, built once.
+ *
+ *  Built top-down, splitting each node's items at the median of their centres along the
+ *  longer axis, so the tree is balanced. Nodes are stored depth-first: a node's first child
+ *  is right after it, so queries walk through memory mostly forwards.
+ */
+class StaticTree {
+private:
+    /**
+     *  A node, a leaf when count > 0
+     */
+    struct Node {
+        AABB    box;
+        int     next;           // Leaf: first of its items. Inner node: its second child
+        int     count;          // Items in a leaf, 0 for an inner node
+    };
+
+    std::vector<Node>   nodes;
+    std::vector<int>    items;  // Item indices, grouped by leaf
+
+    void    build(const AABB* boxes, const std::vector<Vec2>& centers, int begin, int end, int leafSize);
+
+public:
+    void    build(const AABB* boxes, int count, int leafSize = 2);
+
+    /**
+     *  Calls found(item) for every item whose box overlaps a box
+     */
+    template <typename F>
+    void query(const AABB& box, F found) const {
+        if (nodes.empty()) return;
+
+        int stack[STATIC_TREE_MAX_DEPTH + 1], size = 0;
+        stack[size++] = 0;
+        while (size > 0) {
+            const Node& node = nodes[stack[--size]];
+            if (!overlaps(node.box, box)) continue;
+
+            if (node.count > 0) {
+                for (int i = node.next; i < node.next + node.count; i++)
+                    found(items[i]);
+                continue;
+            }
+            stack[size++] = node.next;
+            stack[size++] = (int)(&node - &nodes[0]) + 1;
+        }
+    }
+
+    bool    isEmpty() const                 { return nodes.empty(); }
+    const AABB& getBounds() const           { return nodes[0].box; }
+    int     getNodeCount() const            { return (int)nodes.size(); }
+};
+
+#endif // !__STATIC_TREE_H
@@ -0,0 +1,186 @@
+#include "Stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#define HISTOGRAM_SUB_BUCKETS       (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_HALF_BUCKETS      (HISTOGRAM_SUB_BUCKETS / 2)
+
+
+/**
+ *  Gets the index of the most significant set bit
+ */
+static int highestBit(uint64_t v) {
+    int bit = 0;
+    while (v >>= 1) bit++;
+    return bit;
+}
+
+
+Histogram::Histogram() {
+    counts.resize(getBucket(HISTOGRAM_MAX_NS) + 1);
+    reset();
+}
+
+
+/**
+ *  Gets the bucket of a duration.
+ *  Below HISTOGRAM_SUB_BUCKETS every nanosecond has its own bucket, above that every
+ *  power of two is split into HISTOGRAM_HALF_BUCKETS buckets.
+ */
+int Histogram::getBucket(uint64_t ns) {
+    if (ns < HISTOGRAM_SUB_BUCKETS) return (int)ns;
+
+    int shift = highestBit(ns) - HISTOGRAM_SUB_BUCKET_BITS + 1;
+    return shift * HISTOGRAM_HALF_BUCKETS + (int)(ns >> shift);
+}
+
+
+/**
+ *  Gets the value in the middle of a bucket, in nanoseconds
+ */
+uint64_t Histogram::getBucketValue(int bucket) {
+    if (bucket < HISTOGRAM_SUB_BUCKETS) return (uint64_t)bucket;
+
+    int      shift = bucket / HISTOGRAM_HALF_BUCKETS - 1;
+    uint64_t lower = (uint64_t)(bucket - shift * HISTOGRAM_HALF_BUCKETS) << shift;
+    return lower + ((1ull << shift) >> 1);
+}
+
+
+/**
+ *  Records a duration
+ *  @param ms - The duration in milliseconds
+ */
+void Histogram::record(double ms) {
+    if (!(ms >= 0.0)) ms = 0.0;
+    uint64_t ns = (uint64_t)std::min(ms * 1e6, (double)HISTOGRAM_MAX_NS);
+
+    counts[getBucket(ns)]++;
+    count++;
+    sum  += ms;
+    minMs = std::min(minMs, ms);
+    maxMs = std::max(maxMs, ms);
+}
+
+
+/**
+ *  Adds the values of another histogram to this one
+ */
+void Histogram::merge(const Histogram& other) {
+    for (size_t i = 0; i < counts.size(); i++)
+        counts[i] += other.counts[i];
+    count += other.count;
+    sum   += other.sum;
+    minMs  = std::min(minMs, other.minMs);
+    maxMs  = std::max(maxMs, other.maxMs);
+}
+
+
+/**
+ *  Forgets all recorded values
+ */
+void Histogram::reset() {
+    std::fill(counts.begin(), counts.end(), 0u);
+    count = 0;
+    sum   = 0.0;
+    minMs = INFINITY;
+    maxMs = 0.0;
+}
+
+
+/**
+ *  Gets a percentile (nearest rank)
+ *  @param p - The percentile, between 0 and 100
+ *  @return The value in milliseconds, 0 if nothing was recorded
+ */
+double Histogram::getPercentile(double p) const {
+    if (count == 0) return 0.0;
+
+    uint64_t rank = (uint64_t)std::ceil(p / 100.0 * count);
+    rank = std::max<uint64_t>(1, std::min(rank, count));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            double ms = getBucketValue((int)i) / 1e6;
+            return std::max(minMs, std::min(ms, maxMs));
+        }
+    }
+    return maxMs;
+}
+
+
+/**
+ *  @param logInterval - Seconds between log lines (0 = never log)
+ */
+FrameStats::FrameStats(double logInterval /*= 5.0*/) {
+    this->logInterval = logInterval;
+    windowStart       = -1.0;
+}
+
+
+/**
+ *  Records a duration into a channel
+ *  @param channel - What was timed
+ *  @param ms - How long it took, in milliseconds
+ */
+void FrameStats::record(StatChannel channel, double ms) {
+    window[channel].record(ms);
+    total[channel].record(ms);
+}
+
+
+/**
+ *  Logs and rolls the window once logInterval seconds have passed
+ *  @param now - The current time in seconds
+ *  @return Whether a line was logged
+ */
+bool FrameStats::update(double now) {
+    if (windowStart < 0.0) windowStart = now;
+    if (logInterval <= 0.0 || now - windowStart < logInterval) return false;
+
+    log();
+    for (int i = 0; i < STAT_CHANNEL_COUNT; i++)
+        window[i].reset();
+    windowStart = now;
+    return true;
+}
+
+
+/**
+ *  Prints the tail latencies of the current window, one line for all channels with samples
+ */
+void FrameStats::log() {
+    printf("[stats]");
+    for (int i = 0; i < STAT_CHANNEL_COUNT; i++) {
+        const Histogram& h = window[i];
+        if (h.getCount() == 0) continue;
+        printf(" %s p50 %.2f p90 %.2f p99 %.2f p99.9 %.2f max %.2f ms |",
+               getChannelName((StatChannel)i),
+               h.getPercentile(50.0), h.getPercentile(90.0), h.getPercentile(99.0),
+               h.getPercentile(99.9), h.getMax());
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+
+/**
+ *  Forgets everything that was recorded
+ */
+void FrameStats::reset() {
+    for (int i = 0; i < STAT_CHANNEL_COUNT; i++) {
+        window[i].reset();
+        total[i].reset();
+    }
+    windowStart = -1.0;
+}
+
+
+const char* FrameStats::getChannelName(StatChannel channel) {
+    static const char* names[STAT_CHANNEL_COUNT] = { "frame", "step", "draw", "swap" };
+    return names[channel];
+}
@@ -0,0 +1,101 @@
+#ifndef __STATS_H
+#define __STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#define HISTOGRAM_SUB_BUCKET_BITS   7       // Exact below 2^7 ns, then 64 linear sub-buckets per power of two, under 1% error
+#define HISTOGRAM_MAX_NS            (1ull << 40)    // About 18 minutes, longer values are clamped
+
+
+/**
+ *  A log-linear (HDR-style) histogram of durations.
+ *
+ *  Values are bucketed in nanoseconds: exactly below 128 ns, and above that with 64 buckets
+ *  per power of two, so the relative error stays under 1% at any magnitude while recording
+ *  is O(1) and the memory use is fixed. Minimum and maximum are kept exactly.
+ */
+class Histogram {
+private:
+    std::vector<uint32_t>   counts;
+    uint64_t                count;
+    double                  sum,        // In milliseconds
+                            minMs,
+                            maxMs;
+
+    static int      getBucket(uint64_t ns);
+    static uint64_t getBucketValue(int bucket);
+
+public:
+    Histogram();
+
+    void    record(double ms);
+    void    merge(const Histogram& other);
+    void    reset();
+
+    uint64_t getCount() const               { return count; }
+    double  getMean() const                 { return count ? sum / count : 0.0; }
+    double  getMin() const                  { return count ? minMs : 0.0; }
+    double  getMax() const                  { return maxMs; }
+    double  getPercentile(double p) const;
+};
+
+
+/**
+ *  What is being timed
+ */
+enum StatChannel {
+    STAT_FRAME,
+    STAT_STEP,
+    STAT_DRAW,
+    STAT_SWAP,
+    STAT_CHANNEL_COUNT
+};
+
+
+/**
+ *  Rolling frame-time statistics.
+ *
+ *  Every channel has a histogram over the current window, which is logged and cleared every
+ *  logInterval seconds, and one over the whole run. Nothing here depends on the renderer,
+ *  so the headless benchmark records into it the same way the demo does.
+ */
+class FrameStats {
+private:
+    Histogram   window[STAT_CHANNEL_COUNT],
+                total[STAT_CHANNEL_COUNT];
+    double      logInterval,                // Seconds between log lines, 0 = never log
+                windowStart;                // When the current window began (seconds)
+
+public:
+    FrameStats(double logInterval = 5.0);
+
+    void    record(StatChannel channel, double ms);
+    bool    update(double now);
+    void    log();
+    void    reset();
+
+    void    setLogInterval(double seconds)              { logInterval = seconds; }
+    const Histogram& getWindow(StatChannel channel)     { return window[channel]; }
+    const Histogram& getTotal(StatChannel channel)      { return total[channel]; }
+
+    static const char* getChannelName(StatChannel channel);
+};
+
+
+/**
+ *  Records the time between its construction and destruction into a channel
+ */
+class StatTimer {
+private:
+    FrameStats&                             stats;
+    StatChannel                             channel;
+    std::chrono::steady_clock::time_point   start;
+
+public:
+    StatTimer(FrameStats& stats, StatChannel channel) : stats(stats), channel(channel), start(std::chrono::steady_clock::now()) {}
+    ~StatTimer() { stats.record(channel, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()); }
+};
+
+#endif // !__STATS_H
@@ -0,0 +1,164 @@
+#include "StreamBuffer.h"
+#include "GLState.h"
+
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+
+// ARB_buffer_storage isn't in the GL 3.3 loader, so it is loaded by hand
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT   0x0040
+#define GL_MAP_COHERENT_BIT     0x0080
+#endif
+
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+static PFNGLBUFFERSTORAGEPROC bufferStorage = nullptr;
+
+
+/**
+ *  Checks for (and loads) glBufferStorage, which needs GL 4.4 or ARB_buffer_storage.
+ *  A context must be current.
+ */
+bool StreamBuffer::hasBufferStorage() {
+    static int supported = -1;
+    if (supported >= 0) return supported != 0;
+
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool available = major > 4 || (major == 4 && minor >= 4);
+
+    GLint extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+    for (GLint i = 0; i < extensions && !available; i++) {
+        const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        available = name && !strcmp(name, "GL_ARB_buffer_storage");
+    }
+
+    if (available)
+        bufferStorage = (PFNGLBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+    supported = bufferStorage != nullptr;
+    return supported != 0;
+}
+
+
+/**
+ *  @param target - What the buffer is used as, e.g. GL_ARRAY_BUFFER
+ *  @param regionSize - Bytes written per frame, the buffer grows if more is mapped
+ */
+StreamBuffer::StreamBuffer(GLenum target, size_t regionSize) {
+    this->target = target;
+    buffer       = 0;
+    mapped       = nullptr;
+    written      = 0;
+    for (int i = 0; i < STREAM_BUFFER_REGIONS; i++)
+        fences[i] = nullptr;
+
+    create(regionSize > 0 ? regionSize : 1);
+}
+
+
+StreamBuffer::~StreamBuffer() {
+    destroy();
+}
+
+
+/**
+ *  Allocates the buffer, and maps it if buffer storage is available
+ */
+void StreamBuffer::create(size_t regionSize) {
+    this->regionSize = regionSize;
+    region           = 0;
+
+    glGenBuffers(1, &buffer);
+    GLState::bindBuffer(target, buffer);
+
+    if (hasBufferStorage()) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(target, regionSize * STREAM_BUFFER_REGIONS, nullptr, flags);
+        mapped = (char*)glMapBufferRange(target, 0, regionSize * STREAM_BUFFER_REGIONS, flags);
+        if (mapped) return;
+
+        // Immutable storage can't be respecified, so start over with a plain buffer
+        GLState::deleteBuffers(1, &buffer);
+        glGenBuffers(1, &buffer);
+        GLState::bindBuffer(target, buffer);
+    }
+
+    // Orphaning only ever needs the one region
+    glBufferData(target, regionSize, nullptr, GL_STREAM_DRAW);
+}
+
+
+/**
+ *  Unmaps and deletes the buffer and its fences
+ */
+void StreamBuffer::destroy() {
+    for (int i = 0; i < STREAM_BUFFER_REGIONS; i++) {
+        if (fences[i]) glDeleteSync(fences[i]);
+        fences[i] = nullptr;
+    }
+
+    if (mapped) {
+        GLState::bindBuffer(target, buffer);
+        glUnmapBuffer(target);
+        mapped = nullptr;
+    }
+    GLState::deleteBuffers(1, &buffer);
+    buffer = 0;
+}
+
+
+/**
+ *  Gets memory to write this frame's data to, waiting for the GPU if it's still
+ *  reading the region (which only happens when it's more than two frames behind)
+ *  @param size - How many bytes will be written
+ *  @return Where to write them
+ */
+void* StreamBuffer::map(size_t size) {
+    if (size > regionSize) {
+        size_t grown = regionSize;
+        while (grown < size) grown *= 2;
+        destroy();
+        create(grown);
+    }
+    written = size;
+
+    if (!mapped) {
+        if (staging.size() < regionSize) staging.resize(regionSize);
+        return &staging[0];
+    }
+
+    GLsync& sync = fences[region];
+    if (sync) {
+        while (glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+        glDeleteSync(sync);
+        sync = nullptr;
+    }
+    return mapped + region * regionSize;
+}
+
+
+/**
+ *  Finishes writing this frame's data. The buffer is left bound to the target.
+ *  @return The byte offset in the buffer where the data starts
+ */
+size_t StreamBuffer::unmap() {
+    GLState::bindBuffer(target, buffer);
+    if (mapped) return region * regionSize;         // Coherent, so the GPU already sees the writes
+
+    glBufferData(target, regionSize, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(target, 0, written, &staging[0]);
+    return 0;
+}
+
+
+/**
+ *  Marks the end of the draws that read this frame's region and moves on to the next one
+ */
+void StreamBuffer::fence() {
+    if (!mapped) return;
+
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region = (region + 1) % STREAM_BUFFER_REGIONS;
+}
@@ -0,0 +1,51 @@
+#ifndef __STREAM_BUFFER_H
+#define __STREAM_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+#define STREAM_BUFFER_REGIONS 3     // Frames the GPU may still be reading while the next is written
+
+
+/**
+ *  A ring of buffer regions for data that is rewritten every frame.
+ *
+ *  With ARB_buffer_storage (GL 4.4) the buffer is mapped once, persistently and coherently,
+ *  and each frame is written straight into the region the GPU finished with longest ago;
+ *  a fence per region makes sure it really is finished. Without it, data is written to
+ *  client memory and uploaded by orphaning the buffer, so the driver hands out fresh
+ *  storage instead of stalling on the previous frame's draws.
+ *
+ *  Usage each frame: map(), write, unmap() for the byte offset to draw from, draw, fence().
+ */
+class StreamBuffer {
+private:
+    GLenum              target;
+    GLuint              buffer;
+    size_t              regionSize;                         // Bytes per region
+    int                 region;                             // The region written this frame
+    char*               mapped;                             // Persistent mapping, null when orphaning
+    GLsync              fences[STREAM_BUFFER_REGIONS];      // Signalled when the GPU is done with a region
+    std::vector<char>   staging;                            // Client copy when orphaning
+    size_t              written;                            // Bytes requested by the last map()
+
+    void    create(size_t regionSize);
+    void    destroy();
+
+public:
+    StreamBuffer(GLenum target, size_t regionSize);
+    ~StreamBuffer();
+
+    void*   map(size_t size);
+    size_t  unmap();
+    void    fence();
+
+    GLuint  getBuffer()                 { return buffer; }
+    bool    isPersistent()              { return mapped != nullptr; }
+
+    static bool hasBufferStorage();
+};
+
+#endif // !__STREAM_BUFFER_H
@@ -0,0 +1,266 @@
+#include "TextureAtlas.h"
+#include "AssetPack.h"
+#include "GLState.h"
+#include "TextureFile.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+
+/**
+ *  @param pageSize - Width and height of each atlas texture in pixels
+ *  @param padding - Pixels of extruded edge around each image
+ */
+TextureAtlas::TextureAtlas(int pageSize /*= 2048*/, int padding /*= 4*/) {
+    this->pageSize = pageSize;
+    this->padding  = padding;
+}
+
+
+TextureAtlas::~TextureAtlas() {
+    for (Page& page : pages)
+        GLState::deleteTextures(1, &page.texture);
+}
+
+
+/**
+ *  Queues an image file, named by its path. Of cooked texture files only the full size level is used.
+ *  @param filepath - The image to load, or its name in the pack
+ *  @param pack - Where to look first, read in place (optional)
+ *  @return Whether the image could be loaded
+ */
+bool TextureAtlas::add(const char* filepath, const AssetPack* pack /*= nullptr*/) {
+    Asset asset;
+    bool  packed = pack && pack->find(filepath, asset);
+
+    if (TextureFile::isTextureFile(filepath)) {
+        TextureFile file;
+        if (packed ? !file.open(asset.data, asset.size) : !file.read(filepath)) return false;
+        add(filepath, file.getPixels(0), file.getWidth(), file.getHeight());
+        return true;
+    }
+
+    stbi_set_flip_vertically_on_load(true);
+    int width, height, channels;
+    unsigned char* data = packed ? stbi_load_from_memory(asset.data, (int)asset.size, &width, &height, &channels, 4)
+                                 : stbi_load(filepath, &width, &height, &channels, 4);
+    if (!data) {
+        std::cerr << "Atlas: could not load " << filepath << '\n';
+        return false;
+    }
+
+    add(filepath, data, width, height);
+    stbi_image_free(data);
+    return true;
+}
+
+
+/**
+ *  Queues an image that is already in memory
+ *  @param name - What to find the image by
+ *  @param pixels - RGBA pixels, bottom row first
+ *  @param width - Width of the image
+ *  @param height - Height of the image
+ */
+void TextureAtlas::add(const std::string& name, const unsigned char* pixels, int width, int height) {
+    PendingImage image;
+    image.name   = name;
+    image.width  = width;
+    image.height = height;
+    image.pixels.assign(pixels, pixels + (size_t)width * height * 4);
+    pending.push_back(image);
+}
+
+
+/**
+ *  Creates an empty page
+ *  @return Its index
+ */
+int TextureAtlas::addPage() {
+    Page page;
+    SkylineNode ground = { 0, 0, pageSize };
+    page.skyline.push_back(ground);
+    page.dirty = false;
+
+    glGenTextures(1, &page.texture);
+    GLState::bindTexture(GL_TEXTURE_2D, page.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, pageSize, pageSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    pages.push_back(page);
+    return (int)pages.size() - 1;
+}
+
+
+/**
+ *  Finds the lowest place on the skyline a rectangle fits, preferring narrower nodes on ties
+ *  @param page - The page to look in
+ *  @param width - Width of the rectangle
+ *  @param height - Height of the rectangle
+ *  @param x - Output x-position
+ *  @param y - Output y-position
+ *  @param node - Output index of the skyline node the rectangle starts at
+ *  @return Whether the rectangle fits anywhere
+ */
+bool TextureAtlas::findPosition(const Page& page, int width, int height, int& x, int& y, int& node) {
+    const std::vector<SkylineNode>& skyline = page.skyline;
+    int bestTop = pageSize + 1, bestWidth = pageSize + 1;
+    node = -1;
+
+    for (int i = 0; i < (int)skyline.size(); i++) {
+        if (skyline[i].x + width > pageSize) break;
+
+        // The rectangle rests on the highest node it spans
+        int top = skyline[i].y, left = width;
+        for (int j = i; left > 0; j++) {
+            top   = std::max(top, skyline[j].y);
+            left -= skyline[j].width;
+        }
+        if (top + height > pageSize) continue;
+
+        if (top + height < bestTop || (top + height == bestTop && skyline[i].width < bestWidth)) {
+            bestTop   = top + height;
+            bestWidth = skyline[i].width;
+            node      = i;
+            x         = skyline[i].x;
+            y         = top;
+        }
+    }
+    return node >= 0;
+}
+
+
+/**
+ *  Raises the skyline under a newly placed rectangle
+ */
+void TextureAtlas::addSkylineLevel(Page& page, int node, int x, int y, int width, int height) {
+    std::vector<SkylineNode>& skyline = page.skyline;
+    SkylineNode level = { x, y + height, width };
+    skyline.insert(skyline.begin() + node, level);
+
+    // Cut away the nodes that are now underneath it
+    for (size_t i = node + 1; i < skyline.size(); ) {
+        int end = skyline[i - 1].x + skyline[i - 1].width;
+        if (skyline[i].x >= end) break;
+
+        int overlap = end - skyline[i].x;
+        skyline[i].x     += overlap;
+        skyline[i].width -= overlap;
+        if (skyline[i].width > 0) break;
+        skyline.erase(skyline.begin() + i);
+    }
+
+    // Merge neighbours at the same height
+    for (size_t i = 0; i + 1 < skyline.size(); ) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        }
+        else i++;
+    }
+}
+
+
+/**
+ *  Copies an image into a page with its edges extruded into the padding
+ *  @param x - Left edge of the padded rectangle
+ *  @param y - Bottom edge of the padded rectangle
+ */
+void TextureAtlas::upload(Page& page, const PendingImage& image, int x, int y) {
+    int paddedWidth  = image.width  + 2 * padding,
+        paddedHeight = image.height + 2 * padding;
+    std::vector<unsigned char> padded((size_t)paddedWidth * paddedHeight * 4);
+
+    for (int py = 0; py < paddedHeight; py++) {
+        int sy = std::min(std::max(py - padding, 0), image.height - 1);
+        for (int px = 0; px < paddedWidth; px++) {
+            int sx = std::min(std::max(px - padding, 0), image.width - 1);
+            memcpy(&padded[((size_t)py * paddedWidth + px) * 4], &image.pixels[((size_t)sy * image.width + sx) * 4], 4);
+        }
+    }
+
+    GLState::bindTexture(GL_TEXTURE_2D, page.texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, paddedWidth, paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, &padded[0]);
+    page.dirty = true;
+}
+
+
+/**
+ *  Packs and uploads every queued image, adding pages as they fill up
+ */
+void TextureAtlas::build() {
+    // Tallest first keeps the skyline flat
+    std::stable_sort(pending.begin(), pending.end(), [](const PendingImage& a, const PendingImage& b) {
+        return a.height > b.height;
+    });
+
+    for (const PendingImage& image : pending) {
+        int width  = image.width  + 2 * padding,
+            height = image.height + 2 * padding;
+        if (image.width <= 0 || image.height <= 0 || width > pageSize || height > pageSize) {
+            std::cerr << "Atlas: " << image.name << " doesn't fit in a " << pageSize << "x" << pageSize << " page" << '\n';
+            continue;
+        }
+
+        // The first page with room, or a new one
+        int page = 0, x = 0, y = 0, node = -1;
+        for (; page < (int)pages.size(); page++) {
+            if (findPosition(pages[page], width, height, x, y, node)) break;
+        }
+        if (page == (int)pages.size()) {
+            addPage();
+            findPosition(pages[page], width, height, x, y, node);
+        }
+
+        addSkylineLevel(pages[page], node, x, y, width, height);
+        upload(pages[page], image, x, y);
+
+        AtlasEntry entry;
+        entry.page    = page;
+        entry.texRect = floatRect((float)(x + padding) / pageSize,                (float)(y + padding) / pageSize,
+                                  (float)(x + padding + image.width) / pageSize,  (float)(y + padding + image.height) / pageSize);
+        entries[image.name] = entry;
+    }
+    pending.clear();
+
+    for (Page& page : pages) {
+        if (!page.dirty) continue;
+        GLState::bindTexture(GL_TEXTURE_2D, page.texture);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        page.dirty = false;
+    }
+}
+
+
+/**
+ *  Looks up where an image was packed
+ *  @param name - The image's name (its path for files)
+ *  @param entry - Output page and rectangle
+ *  @return Whether the image is in the atlas
+ */
+bool TextureAtlas::find(const std::string& name, AtlasEntry& entry) {
+    auto it = entries.find(name);
+    if (it == entries.end()) return false;
+
+    entry = it->second;
+    return true;
+}
+
+
+/**
+ *  Converts a rectangle in an image's own texture coordinates (0-1) to atlas coordinates
+ *  @param entry - Where the image is in the atlas
+ *  @param texRect - The rectangle within the image
+ */
+floatRect TextureAtlas::remap(const AtlasEntry& entry, const floatRect& texRect) {
+    const floatRect& r = entry.texRect;
+    float w = r.x1 - r.x0,
+          h = r.y1 - r.y0;
+    return floatRect(r.x0 + texRect.x0 * w, r.y0 + texRect.y0 * h,
+                     r.x0 + texRect.x1 * w, r.y0 + texRect.y1 * h);
+}
@@ -0,0 +1,87 @@
+#ifndef __TEXTURE_ATLAS_H
+#define __TEXTURE_ATLAS_H
+
+#include <glad/glad.h>
+
+#include <map>
+#include <string>
+#include <vector>
+#include "Sprite.h"
+
+class AssetPack;
+
+
+/**
+ *  Where an image ended up in the atlas
+ */
+struct AtlasEntry {
+    int         page;                   // Index of the page texture
+    floatRect   texRect;                // The image's rectangle in the page (bottom-left, top-right)
+};
+
+
+/**
+ *  Packs many images into a few large textures, so sprites with different images can
+ *  still be batched together.
+ *
+ *  Images are queued with add() and packed by build(), tallest first, with a skyline
+ *  bottom-left packer; build() can be called again to add more images to the same pages.
+ *  Every image is surrounded by `padding` pixels copied from its own edges, so neither
+ *  linear filtering nor the first few mip levels bleed in the neighbours.
+ */
+class TextureAtlas {
+private:
+    /**
+     *  A horizontal segment of the top edge of everything packed so far
+     */
+    struct SkylineNode {
+        int     x, y,
+                width;
+    };
+
+    /**
+     *  One atlas texture
+     */
+    struct Page {
+        std::vector<SkylineNode>    skyline;
+        GLuint                      texture;
+        bool                        dirty;      // Images were added since the mipmaps were made
+    };
+
+    /**
+     *  An image waiting to be packed
+     */
+    struct PendingImage {
+        std::string                 name;
+        std::vector<unsigned char>  pixels;     // RGBA, bottom row first like stbi's flipped loads
+        int                         width,
+                                    height;
+    };
+
+    int                                 pageSize,
+                                        padding;
+    std::vector<Page>                   pages;
+    std::vector<PendingImage>           pending;
+    std::map<std::string, AtlasEntry>   entries;
+
+    bool    findPosition(const Page& page, int width, int height, int& x, int& y, int& node);
+    void    addSkylineLevel(Page& page, int node, int x, int y, int width, int height);
+    void    upload(Page& page, const PendingImage& image, int x, int y);
+    int     addPage();
+
+public:
+    TextureAtlas(int pageSize = 2048, int padding = 4);
+    ~TextureAtlas();
+
+    bool    add(const char* filepath, const AssetPack* pack = nullptr);
+    void    add(const std::string& name, const unsigned char* pixels, int width, int height);
+    void    build();
+
+    bool    find(const std::string& name, AtlasEntry& entry);
+    floatRect remap(const AtlasEntry& entry, const floatRect& texRect);
+
+    GLuint  getTexture(int page)            { return pages[page].texture; }
+    int     getPageCount()                  { return (int)pages.size(); }
+};
+
+#endif // !__TEXTURE_ATLAS_H
@@ -0,0 +1,210 @@
+#include "TextureCache.h"
+#include "GLState.h"
+#include "AssetPack.h"
+#include "TextureFile.h"
+#include "TextureLoader.h"
+#include "stb_image.h"
+
+#include <iostream>
+
+
+/**
+ *  @param budget - How many bytes of textures to keep, referenced or not
+ */
+TextureCache::TextureCache(size_t budget /*= 256 MB*/) {
+    this->budget = budget;
+    usage        = 0;
+    useCounter   = 0;
+    loader       = nullptr;
+    pack         = nullptr;
+}
+
+
+TextureCache::~TextureCache() {
+    clear();
+}
+
+
+/**
+ *  Decodes an image file and uploads it as a mipmapped texture, without caching it.
+ *  Cooked texture files (.rbtex) are uploaded as they are, mipmaps included.
+ *  @param path - The image file, or its name in the pack
+ *  @param width - Output width of the image (optional)
+ *  @param height - Output height of the image (optional)
+ *  @param pack - Where to look first, read in place (optional)
+ *  @return The texture, 0 if the file couldn't be loaded
+ */
+GLuint TextureCache::load(const char* path, int* width /*= nullptr*/, int* height /*= nullptr*/,
+                          const AssetPack* pack /*= nullptr*/) {
+    Asset asset;
+    bool  packed = pack && pack->find(path, asset);
+
+    if (TextureFile::isTextureFile(path)) {
+        TextureFile file;
+        if (packed ? !file.open(asset.data, asset.size) : !file.read(path)) {
+            std::cerr << "Texture load failed: " << path << '\n';
+            return 0;
+        }
+        return uploadCooked(file, width, height);
+    }
+
+    stbi_set_flip_vertically_on_load(true);
+    int texWidth, texHeight, nrChannels;
+    unsigned char* data = packed ? stbi_load_from_memory(asset.data, (int)asset.size, &texWidth, &texHeight, &nrChannels, 4)
+                                 : stbi_load(path, &texWidth, &texHeight, &nrChannels, 4);
+    if (!data) {
+        std::cerr << "Texture load failed: " << path << '\n';
+        return 0;
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    GLState::bindTexture(GL_TEXTURE_2D, texture);
+
+    // set the texture wrapping parameters
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    // set texture filtering parameters
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texWidth, texHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    stbi_image_free(data);
+
+    if (width)  *width  = texWidth;
+    if (height) *height = texHeight;
+    return texture;
+}
+
+
+/**
+ *  Uploads each level of a cooked texture file
+ */
+GLuint TextureCache::uploadCooked(const TextureFile& file, int* width, int* height) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    GLState::bindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, file.getLevelCount() - 1);
+
+    for (int i = 0; i < file.getLevelCount(); i++) {
+        const TextureFileLevel& level = file.getLevel(i);
+        glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, file.getPixels(i));
+    }
+
+    if (width)  *width  = file.getWidth();
+    if (height) *height = file.getHeight();
+    return texture;
+}
+
+
+/**
+ *  Gets the texture of a file, loading it the first time, and adds a reference to it
+ *  @param path - The image file, used as the key as given
+ *  @param width - Output width of the image, 0 while a loader is still loading it (optional)
+ *  @param height - Output height of the image, 0 while a loader is still loading it (optional)
+ *  @return The texture, 0 if the file couldn't be loaded
+ */
+GLuint TextureCache::acquire(const std::string& path, int* width /*= nullptr*/, int* height /*= nullptr*/) {
+    auto it = entries.find(path);
+    if (it == entries.end()) {
+        Entry entry;
+        entry.width  = 0;
+        entry.height = 0;
+        if (loader) entry.texture = loader->load(path, [this](GLuint texture, int width, int height) {
+                                                     onLoaded(texture, width, height);
+                                                 });
+        else        entry.texture = load(path.c_str(), &entry.width, &entry.height, pack);
+        if (!entry.texture) return 0;
+
+        entry.bytes      = (size_t)entry.width * entry.height * 4 * 4 / 3;
+        entry.references = 0;
+        it = entries.emplace(path, entry).first;
+        paths[entry.texture] = path;
+        usage += entry.bytes;
+    }
+
+    Entry& entry = it->second;
+    entry.references++;
+    entry.lastUsed = ++useCounter;
+    if (width)  *width  = entry.width;
+    if (height) *height = entry.height;
+
+    // Make room by dropping textures nobody uses anymore
+    evict();
+    return entry.texture;
+}
+
+
+/**
+ *  Accounts for the size of an image the loader finished
+ */
+void TextureCache::onLoaded(GLuint texture, int width, int height) {
+    auto path = paths.find(texture);
+    if (path == paths.end()) return;
+
+    Entry& entry = entries[path->second];
+    entry.width  = width;
+    entry.height = height;
+    usage       -= entry.bytes;
+    entry.bytes  = (size_t)width * height * 4 * 4 / 3;
+    usage       += entry.bytes;
+    evict();
+}
+
+
+/**
+ *  Removes a reference to a texture. It stays cached while the budget allows.
+ *  @param texture - A texture returned by acquire()
+ */
+void TextureCache::release(GLuint texture) {
+    auto path = paths.find(texture);
+    if (path == paths.end()) return;
+
+    Entry& entry = entries[path->second];
+    if (entry.references > 0) entry.references--;
+    entry.lastUsed = ++useCounter;
+    evict();
+}
+
+
+/**
+ *  Deletes unreferenced textures, least recently used first, until the usage is within budget
+ */
+void TextureCache::evict() {
+    while (usage > budget) {
+        auto oldest = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->second.references == 0 && (oldest == entries.end() || it->second.lastUsed < oldest->second.lastUsed))
+                oldest = it;
+        }
+        if (oldest == entries.end()) return;      // Everything left is in use
+        remove(oldest);
+    }
+}
+
+
+/**
+ *  Deletes a texture and forgets it
+ */
+void TextureCache::remove(std::unordered_map<std::string, Entry>::iterator it) {
+    if (loader) loader->cancel(it->second.texture);
+    GLState::deleteTextures(1, &it->second.texture);
+    paths.erase(it->second.texture);
+    usage -= it->second.bytes;
+    entries.erase(it);
+}
+
+
+/**
+ *  Deletes every texture, referenced or not
+ */
+void TextureCache::clear() {
+    while (!entries.empty())
+        remove(entries.begin());
+}
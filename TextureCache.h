@@ -0,0 +1,74 @@
+#ifndef __TEXTURE_CACHE_H
+#define __TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+class AssetPack;
+class TextureFile;
+class TextureLoader;
+
+
+/**
+ *  Shares textures loaded from files.
+ *
+ *  Each file is decoded and uploaded once; every acquire() adds a reference and every
+ *  release() removes one. Textures nobody references stay cached until the memory they use
+ *  exceeds the budget, then the least recently used ones are deleted first. Referenced
+ *  textures are never evicted, so the budget can be exceeded while they are all in use.
+ *
+ *  With a loader set, files are decoded on its thread pool and acquire() returns a texture
+ *  that shows a placeholder until the image is uploaded. The loader must outlive the cache.
+ *  Synchronous loads look paths up in the pack given to setPack() before the disk.
+ */
+class TextureCache {
+private:
+    /**
+     *  A loaded texture
+     */
+    struct Entry {
+        GLuint      texture;
+        int         width,
+                    height;
+        size_t      bytes;                  // Estimated GPU memory, mipmaps included
+        int         references;
+        uint64_t    lastUsed;               // Value of useCounter when last acquired or released
+    };
+
+    std::unordered_map<std::string, Entry>  entries;
+    std::unordered_map<GLuint, std::string> paths;      // Path of each texture, for release()
+    size_t                                  budget,     // Bytes
+                                            usage;      // Bytes
+    uint64_t                                useCounter;
+    TextureLoader*                          loader;     // Null = load synchronously
+    const AssetPack*                        pack;       // Looked in first when loading synchronously
+
+    void    evict();
+    static GLuint uploadCooked(const TextureFile& file, int* width, int* height);
+    void    remove(std::unordered_map<std::string, Entry>::iterator it);
+    void    onLoaded(GLuint texture, int width, int height);
+
+public:
+    TextureCache(size_t budget = 256 * 1024 * 1024);
+    ~TextureCache();
+
+    GLuint  acquire(const std::string& path, int* width = nullptr, int* height = nullptr);
+    void    release(GLuint texture);
+    void    clear();
+
+    void    setBudget(size_t bytes)         { budget = bytes; evict(); }
+    void    setLoader(TextureLoader* loader){ this->loader = loader; }
+    void    setPack(const AssetPack* pack)  { this->pack = pack; }
+    size_t  getBudget()                     { return budget; }
+    size_t  getMemoryUsage()                { return usage; }
+    int     getTextureCount()               { return (int)entries.size(); }
+
+    static GLuint load(const char* path, int* width = nullptr, int* height = nullptr,
+                       const AssetPack* pack = nullptr);
+};
+
+#endif // !__TEXTURE_CACHE_H
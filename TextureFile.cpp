@@ -0,0 +1,241 @@
+#include "TextureFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+
+/**
+ *  Rounds up to a multiple of 8, so the mask words and levels are aligned
+ */
+static size_t align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+
+/**
+ *  Halves an image with a box filter. Odd edges are clamped, so 1-pixel sides stay 1.
+ *  @param src - RGBA pixels
+ *  @param dst - Output RGBA pixels, max(w/2, 1) by max(h/2, 1)
+ */
+static void downsample(const unsigned char* src, int w, int h, unsigned char* dst) {
+    int dw = w > 1 ? w / 2 : 1,
+        dh = h > 1 ? h / 2 : 1;
+    for (int y = 0; y < dh; y++) {
+        int y0 = std::min(2 * y, h - 1), y1 = std::min(2 * y + 1, h - 1);
+        for (int x = 0; x < dw; x++) {
+            int x0 = std::min(2 * x, w - 1), x1 = std::min(2 * x + 1, w - 1);
+            for (int c = 0; c < 4; c++) {
+                int sum = src[((size_t)y0 * w + x0) * 4 + c] + src[((size_t)y0 * w + x1) * 4 + c]
+                        + src[((size_t)y1 * w + x0) * 4 + c] + src[((size_t)y1 * w + x1) * 4 + c];
+                dst[((size_t)y * dw + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+
+TextureFile::TextureFile() {
+    data = nullptr;
+    size = 0;
+}
+
+
+/**
+ *  Reads a whole texture file with one read
+ *  @return Whether it exists and is a valid texture file
+ */
+bool TextureFile::read(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    bool ok = fileSize > 0;
+    if (ok) {
+        storage.resize((size_t)fileSize);
+        ok = fread(&storage[0], 1, (size_t)fileSize, file) == (size_t)fileSize;
+    }
+    fclose(file);
+
+    if (!ok || !open(&storage[0], storage.size())) {
+        std::cerr << "Not a valid texture file: " << path << '\n';
+        storage.clear();
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ *  Views a texture file in memory, which must stay there while this is used
+ *  @param data - The file, 8-byte aligned
+ *  @param size - Its size in bytes
+ *  @return Whether it is a valid texture file
+ */
+bool TextureFile::open(const void* data, size_t size) {
+    this->data = (const unsigned char*)data;
+    this->size = size;
+    if (size >= sizeof(TextureFileHeader) && (uintptr_t)data % 8 == 0 && validate()) return true;
+
+    this->data = nullptr;
+    this->size = 0;
+    return false;
+}
+
+
+/**
+ *  Checks that the header is ours and that everything it points to is inside the file
+ */
+bool TextureFile::validate() const {
+    const TextureFileHeader& header = getHeader();
+    if (header.magic != TEXTURE_FILE_MAGIC || header.version != TEXTURE_FILE_VERSION ||
+        header.format != TEXTURE_FORMAT_RGBA8 || header.levels == 0 || header.levels > 32 ||
+        header.width == 0 || header.height == 0)
+        return false;
+
+    if (sizeof(TextureFileHeader) + header.levels * sizeof(TextureFileLevel) > size) return false;
+    if ((size_t)header.maskOffset + header.maskSize > size || header.maskOffset % 8 != 0 ||
+        header.maskSize < (size_t)getMaskStride() * header.height * 8)
+        return false;
+
+    for (int i = 0; i < (int)header.levels; i++) {
+        const TextureFileLevel& level = getLevel(i);
+        if ((size_t)level.offset + level.size > size || level.size < (size_t)level.width * level.height * 4)
+            return false;
+    }
+    return true;
+}
+
+
+/**
+ *  Gets the size and place of a mip level (0 = full size)
+ */
+const TextureFileLevel& TextureFile::getLevel(int level) const {
+    return ((const TextureFileLevel*)&data[sizeof(TextureFileHeader)])[level];
+}
+
+
+/**
+ *  Gets the RGBA pixels of a mip level
+ */
+const unsigned char* TextureFile::getPixels(int level) const {
+    return &data[getLevel(level).offset];
+}
+
+
+/**
+ *  Gets the alpha mask, getMaskStride() words per row, bottom row first
+ */
+const uint64_t* TextureFile::getMask() const {
+    return (const uint64_t*)&data[getHeader().maskOffset];
+}
+
+
+/**
+ *  Tells whether a pixel of level 0 is solid
+ */
+bool TextureFile::getMaskBit(int x, int y) const {
+    return (getMask()[(size_t)y * getMaskStride() + x / 64] >> (x % 64)) & 1;
+}
+
+
+/**
+ *  Tells whether a path is a texture file by its extension
+ */
+bool TextureFile::isTextureFile(const char* path) {
+    size_t length = strlen(path), extension = strlen(TEXTURE_FILE_EXTENSION);
+    return length >= extension && !strcmp(path + length - extension, TEXTURE_FILE_EXTENSION);
+}
+
+
+/**
+ *  Builds an alpha mask the way texture files store it
+ *  @param pixels - RGBA pixels, bottom row first
+ *  @param alphaThreshold - Alpha from which a pixel is solid
+ *  @param mask - Output mask, (width + 63) / 64 words per row
+ */
+void TextureFile::buildMask(const unsigned char* pixels, int width, int height, int alphaThreshold,
+                            std::vector<uint64_t>& mask) {
+    int stride = (width + 63) / 64;
+    mask.assign((size_t)stride * height, 0);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (pixels[((size_t)y * width + x) * 4 + 3] >= alphaThreshold)
+                mask[(size_t)y * stride + x / 64] |= (uint64_t)1 << (x % 64);
+        }
+    }
+}
+
+
+/**
+ *  Cooks an image into a texture file
+ *  @param path - The file to write
+ *  @param pixels - RGBA pixels, bottom row first
+ *  @param width - Width of the image
+ *  @param height - Height of the image
+ *  @param alphaThreshold - Alpha from which a pixel is solid in the mask
+ *  @param mipmaps - Whether to store the mip chain down to 1x1, or only the image itself
+ *  @return Whether the file could be written
+ */
+bool TextureFile::write(const char* path, const unsigned char* pixels, int width, int height,
+                        int alphaThreshold /*= 128*/, bool mipmaps /*= true*/) {
+    if (width <= 0 || height <= 0) return false;
+
+    // The mip chain, each level half the previous one
+    std::vector<std::vector<unsigned char>> chain(1);
+    std::vector<TextureFileLevel>           levels(1);
+    chain[0].assign(pixels, pixels + (size_t)width * height * 4);
+    levels[0].width  = (uint32_t)width;
+    levels[0].height = (uint32_t)height;
+    while (mipmaps && (levels.back().width > 1 || levels.back().height > 1)) {
+        const TextureFileLevel& previous = levels.back();
+        TextureFileLevel level;
+        level.width  = previous.width  > 1 ? previous.width  / 2 : 1;
+        level.height = previous.height > 1 ? previous.height / 2 : 1;
+
+        std::vector<unsigned char> halved((size_t)level.width * level.height * 4);
+        downsample(&chain.back()[0], (int)previous.width, (int)previous.height, &halved[0]);
+        chain.push_back(halved);
+        levels.push_back(level);
+    }
+
+    // The alpha mask, one bit per pixel
+    std::vector<uint64_t> mask;
+    buildMask(pixels, width, height, alphaThreshold, mask);
+
+    // Header, level table, mask, then the levels
+    TextureFileHeader header;
+    header.magic      = TEXTURE_FILE_MAGIC;
+    header.version    = TEXTURE_FILE_VERSION;
+    header.format     = TEXTURE_FORMAT_RGBA8;
+    header.width      = (uint32_t)width;
+    header.height     = (uint32_t)height;
+    header.levels     = (uint32_t)levels.size();
+    header.maskOffset = (uint32_t)align8(sizeof(header) + levels.size() * sizeof(TextureFileLevel));
+    header.maskSize   = (uint32_t)(mask.size() * sizeof(uint64_t));
+
+    size_t offset = align8((size_t)header.maskOffset + header.maskSize);
+    for (TextureFileLevel& level : levels) {
+        level.offset = (uint32_t)offset;
+        level.size   = level.width * level.height * 4;
+        offset       = align8(offset + level.size);
+    }
+
+    std::vector<unsigned char> file(offset, 0);
+    memcpy(&file[0], &header, sizeof(header));
+    memcpy(&file[sizeof(header)], &levels[0], levels.size() * sizeof(TextureFileLevel));
+    memcpy(&file[header.maskOffset], &mask[0], header.maskSize);
+    for (size_t i = 0; i < levels.size(); i++)
+        memcpy(&file[levels[i].offset], &chain[i][0], levels[i].size);
+
+    FILE* out = fopen(path, "wb");
+    if (!out) {
+        std::cerr << "Could not write " << path << '\n';
+        return false;
+    }
+    bool ok = fwrite(&file[0], 1, file.size(), out) == file.size();
+    fclose(out);
+    return ok;
+}
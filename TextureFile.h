@@ -0,0 +1,89 @@
+#ifndef __TEXTURE_FILE_H
+#define __TEXTURE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define TEXTURE_FILE_MAGIC      0x58544252u     // "RBTX"
+#define TEXTURE_FILE_VERSION    1
+#define TEXTURE_FILE_EXTENSION  ".rbtex"
+
+
+/**
+ *  How the pixels of a texture file are stored
+ */
+enum TextureFormat {
+    TEXTURE_FORMAT_RGBA8 = 0,           // 4 bytes per pixel, uncompressed
+};
+
+
+/**
+ *  The start of a texture file
+ */
+struct TextureFileHeader {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    format;                 // A TextureFormat
+    uint32_t    width,
+                height;
+    uint32_t    levels;                 // Mip levels, each followed by a TextureFileLevel
+    uint32_t    maskOffset,             // Alpha mask, from the start of the file
+                maskSize;               // Bytes
+};
+
+
+/**
+ *  Where a mip level is in a texture file
+ */
+struct TextureFileLevel {
+    uint32_t    width,
+                height;
+    uint32_t    offset,                 // From the start of the file
+                size;                   // Bytes
+};
+
+
+/**
+ *  A cooked texture: every mip level, decoded, plus an alpha mask for collision shapes.
+ *
+ *  Written by rbphys_cook at build time, so loading at runtime is one read and one
+ *  glTexImage2D per level instead of decoding a PNG and generating mipmaps.
+ *  Rows are stored bottom row first, like stbi's flipped loads. The mask has one bit per
+ *  pixel of level 0 (set = alpha at or above the cook threshold), packed into 64-bit words,
+ *  getMaskStride() words per row. Multi-byte fields are little-endian.
+ *  open() views a file that is already in memory (e.g. in an AssetPack) without copying it.
+ */
+class TextureFile {
+private:
+    std::vector<unsigned char>  storage;    // The whole file when it was read
+    const unsigned char*        data;       // The whole file, in storage or somewhere else
+    size_t                      size;
+
+    const TextureFileHeader&    getHeader() const   { return *(const TextureFileHeader*)data; }
+    bool    validate() const;
+
+public:
+    TextureFile();
+
+    bool    read(const char* path);
+    bool    open(const void* data, size_t size);
+    static bool write(const char* path, const unsigned char* pixels, int width, int height,
+                      int alphaThreshold = 128, bool mipmaps = true);
+    static void buildMask(const unsigned char* pixels, int width, int height, int alphaThreshold,
+                          std::vector<uint64_t>& mask);
+
+    static bool isTextureFile(const char* path);
+
+    int     getWidth() const                        { return (int)getHeader().width; }
+    int     getHeight() const                       { return (int)getHeader().height; }
+    int     getLevelCount() const                   { return (int)getHeader().levels; }
+    const TextureFileLevel& getLevel(int level) const;
+    const unsigned char*    getPixels(int level) const;
+
+    const uint64_t* getMask() const;
+    int     getMaskStride() const                   { return (getWidth() + 63) / 64; }
+    bool    getMaskBit(int x, int y) const;
+};
+
+#endif // !__TEXTURE_FILE_H
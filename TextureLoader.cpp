@@ -0,0 +1,221 @@
+#include "TextureLoader.h"
+#include "GLState.h"
+#include "Profiler.h"
+#include "stb_image.h"
+
+#include <cstring>
+#include <iostream>
+
+
+/**
+ *  @param pool - Where the files are decoded
+ *  @param uploadBudget - Bytes uploaded per update() at most (one image always goes, however big)
+ */
+TextureLoader::TextureLoader(ThreadPool& pool, size_t uploadBudget /*= 8 MB*/)
+    : pool(pool), shared(new Shared()), uploadBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBudget) {
+    this->uploadBudget = uploadBudget;
+    nextId             = 0;
+    pack               = nullptr;
+    shared->closed     = false;
+
+    // Texture uploads from client memory elsewhere need the unpack buffer unbound
+    GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+
+/**
+ *  Drops the images that weren't uploaded yet; their textures keep the placeholder.
+ *  Jobs still on the pool throw their results away when they finish.
+ */
+TextureLoader::~TextureLoader() {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    shared->closed = true;
+    for (Job& job : shared->decoded)
+        freeJob(job);
+    for (Job& job : ready)
+        freeJob(job);
+}
+
+
+void TextureLoader::freeJob(Job& job) {
+    if (job.pixels) stbi_image_free(job.pixels);
+    delete job.file;
+    job.pixels = nullptr;
+    job.file   = nullptr;
+}
+
+
+/**
+ *  Gets the bytes a decoded job uploads, all levels of a cooked file
+ */
+size_t TextureLoader::getUploadSize(const Job& job) {
+    if (!job.file) return (size_t)job.width * job.height * 4;
+
+    size_t size = 0;
+    for (int i = 0; i < job.file->getLevelCount(); i++)
+        size += job.file->getLevel(i).size;
+    return size;
+}
+
+
+/**
+ *  Creates a texture showing a placeholder and starts decoding the file into it
+ *  @param path - The image file, or its name in the pack
+ *  @param onLoaded - Called from update() once the image is in the texture (width and height are 0 if it couldn't be loaded)
+ *  @return The texture, usable right away
+ */
+GLuint TextureLoader::load(const std::string& path, const TextureCallback& onLoaded /*= nullptr*/) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    GLState::bindTexture(GL_TEXTURE_2D, texture);
+
+    // Same parameters as TextureCache::load(), the mipmaps follow with the image
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+
+    Job job;
+    job.id       = nextId++;
+    job.texture  = texture;
+    job.path     = path;
+    job.onLoaded = onLoaded;
+    job.pixels   = nullptr;
+    job.file     = nullptr;
+    job.width    = 0;
+    job.height   = 0;
+    job.pack     = pack;
+    pending[texture] = job.id;
+
+    std::shared_ptr<Shared> shared = this->shared;
+    pool.submit([shared, job]() mutable {
+        PROFILE_ZONE("TextureLoader::decode");
+        Asset asset;
+        bool  packed = job.pack && job.pack->find(job.path, asset);
+
+        if (TextureFile::isTextureFile(job.path.c_str())) {
+            job.file = new TextureFile();
+            if (packed ? job.file->open(asset.data, asset.size) : job.file->read(job.path.c_str())) {
+                job.width  = job.file->getWidth();
+                job.height = job.file->getHeight();
+            }
+            else freeJob(job);
+        }
+        else {
+            int channels;
+            stbi_set_flip_vertically_on_load_thread(true);
+            job.pixels = packed ? stbi_load_from_memory(asset.data, (int)asset.size, &job.width, &job.height, &channels, 4)
+                                : stbi_load(job.path.c_str(), &job.width, &job.height, &channels, 4);
+        }
+
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        if (shared->closed) freeJob(job);
+        else                shared->decoded.push_back(job);
+    });
+    return texture;
+}
+
+
+/**
+ *  Stops a texture from being uploaded to, which must happen before it's deleted
+ *  (GL may hand the name out again)
+ */
+void TextureLoader::cancel(GLuint texture) {
+    pending.erase(texture);
+}
+
+
+/**
+ *  Uploads decoded images, as many as fit in the upload budget. Call once per frame.
+ */
+void TextureLoader::update() {
+    {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        for (Job& job : shared->decoded)
+            ready.push_back(job);
+        shared->decoded.clear();
+    }
+    if (ready.empty()) return;
+    PROFILE_ZONE("TextureLoader::update");
+
+    // Take images until the budget is used up, dropping cancelled ones and reporting failed ones
+    size_t bytes = 0;
+    uploads.clear();
+    while (!ready.empty()) {
+        Job& job = ready.front();
+        auto it  = pending.find(job.texture);
+        if (it == pending.end() || it->second != job.id) {
+            freeJob(job);
+            ready.pop_front();
+            continue;
+        }
+
+        if (!job.pixels && !job.file) {
+            std::cerr << "Texture load failed: " << job.path << '\n';
+            pending.erase(it);
+            if (job.onLoaded) job.onLoaded(job.texture, 0, 0);
+            ready.pop_front();
+            continue;
+        }
+
+        size_t size = getUploadSize(job);
+        if (!uploads.empty() && bytes + size > uploadBudget) break;
+        bytes += size;
+        uploads.push_back(job);
+        ready.pop_front();
+    }
+    if (uploads.empty()) return;
+
+    // Copy every level into the unpack buffer back to back, noting where each one went
+    char* out = (char*)uploadBuffer.map(bytes);
+    size_t offset = 0;
+    uploadLevels.clear();
+    for (Job& job : uploads) {
+        int count = job.file ? job.file->getLevelCount() : 1;
+        for (int i = 0; i < count; i++) {
+            TextureFileLevel level;
+            if (job.file) level = job.file->getLevel(i);
+            else {
+                level.width  = (uint32_t)job.width;
+                level.height = (uint32_t)job.height;
+                level.size   = (uint32_t)getUploadSize(job);
+            }
+            memcpy(out + offset, job.file ? job.file->getPixels(i) : job.pixels, level.size);
+            level.offset = (uint32_t)offset;
+            uploadLevels.push_back(level);
+            offset += level.size;
+        }
+    }
+    size_t base = uploadBuffer.unmap();
+
+    // Then let GL read them from there
+    const TextureFileLevel* level = uploadLevels.empty() ? nullptr : &uploadLevels[0];
+    for (Job& job : uploads) {
+        int  count  = job.file ? job.file->getLevelCount() : 1;
+        bool cooked = job.file != nullptr;
+        freeJob(job);
+        level += count;
+
+        // A callback of an earlier upload may have cancelled this one
+        auto it = pending.find(job.texture);
+        if (it == pending.end() || it->second != job.id) continue;
+        pending.erase(it);
+
+        GLState::bindTexture(GL_TEXTURE_2D, job.texture);
+        for (int i = 0; i < count; i++) {
+            const TextureFileLevel& mip = level[i - count];
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, mip.width, mip.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, (void*)(base + mip.offset));
+        }
+
+        // Cooked files come with their mipmaps, which may stop short of 1x1
+        if (cooked) glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, count - 1);
+        else        glGenerateMipmap(GL_TEXTURE_2D);
+        if (job.onLoaded) job.onLoaded(job.texture, job.width, job.height);
+    }
+
+    uploadBuffer.fence();
+    GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
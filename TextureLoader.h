@@ -0,0 +1,89 @@
+#ifndef __TEXTURE_LOADER_H
+#define __TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AssetPack.h"
+#include "StreamBuffer.h"
+#include "TextureFile.h"
+#include "ThreadPool.h"
+
+typedef std::function<void(GLuint texture, int width, int height)> TextureCallback;
+
+
+/**
+ *  Loads textures without blocking the main thread.
+ *
+ *  load() returns a texture right away that holds a one-texel placeholder, and decodes the
+ *  file on the thread pool. update() (once per frame, on the main thread) uploads the
+ *  decoded images into their textures through a pixel unpack buffer, at most the upload
+ *  budget's worth of bytes per frame, so a level's worth of images arrives over a few frames
+ *  instead of freezing one. Anything drawn with a texture shows the placeholder until then.
+ *  Cooked texture files (.rbtex) are read on the pool instead, and upload all their levels.
+ *  With a pack set, paths found in it are decoded (or viewed, if cooked) straight from the
+ *  mapping; the pack must stay open until the pool has finished.
+ */
+class TextureLoader {
+private:
+    /**
+     *  One image being loaded
+     */
+    struct Job {
+        uint64_t        id;
+        GLuint          texture;
+        std::string     path;
+        TextureCallback onLoaded;
+        unsigned char*  pixels;         // RGBA from stbi, null if decoding failed
+        TextureFile*    file;           // Read instead of pixels for cooked files, null if that failed
+        const AssetPack* pack;          // Looked in before the disk, may be null
+        int             width,
+                        height;
+    };
+
+    /**
+     *  What the workers hand results back through. Shared with the jobs, so a job that
+     *  finishes after the loader is gone has somewhere to go.
+     */
+    struct Shared {
+        std::mutex          mutex;
+        std::vector<Job>    decoded;
+        bool                closed;
+    };
+
+    ThreadPool&                         pool;
+    std::shared_ptr<Shared>             shared;
+    std::deque<Job>                     ready;          // Decoded, waiting for upload budget
+    std::vector<Job>                    uploads;        // This frame's uploads
+    std::vector<TextureFileLevel>       uploadLevels;   // Their levels, offsets in the upload buffer
+    std::unordered_map<GLuint, uint64_t> pending;       // Job of each texture that isn't uploaded yet
+    StreamBuffer                        uploadBuffer;
+    size_t                              uploadBudget;   // Bytes per frame
+    const AssetPack*                    pack;
+    uint64_t                            nextId;
+
+    static void     freeJob(Job& job);
+    static size_t   getUploadSize(const Job& job);
+
+public:
+    TextureLoader(ThreadPool& pool, size_t uploadBudget = 8 * 1024 * 1024);
+    ~TextureLoader();
+
+    GLuint  load(const std::string& path, const TextureCallback& onLoaded = nullptr);
+    void    cancel(GLuint texture);
+    void    update();
+
+    void    setUploadBudget(size_t bytes)   { uploadBudget = bytes; }
+    void    setPack(const AssetPack* pack)  { this->pack = pack; }
+    int     getPendingCount()               { return (int)pending.size(); }
+};
+
+#endif // !__TEXTURE_LOADER_H
@@ -0,0 +1,72 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+
+/**
+ *  @param threads - Number of workers (0 = one per hardware thread, leaving one for the main thread)
+ */
+ThreadPool::ThreadPool(int threads /*= 0*/) {
+    busy     = 0;
+    stopping = false;
+
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency() - 1;
+    if (threads <= 0) threads = 1;
+    for (int i = 0; i < threads; i++)
+        workers.push_back(std::thread(&ThreadPool::run, this));
+}
+
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+
+/**
+ *  Queues a job to run on a worker
+ */
+void ThreadPool::submit(const std::function<void()>& job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(job);
+    }
+    wake.notify_one();
+}
+
+
+/**
+ *  Gets the number of jobs that are queued or running
+ */
+int ThreadPool::getQueuedCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return (int)jobs.size() + busy;
+}
+
+
+/**
+ *  A worker: takes jobs until the pool is destroyed
+ */
+void ThreadPool::run() {
+    PROFILE_THREAD_NAME("worker");
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (stopping) return;
+
+        std::function<void()> job = jobs.front();
+        jobs.pop_front();
+        busy++;
+
+        lock.unlock();
+        job();
+        lock.lock();
+        busy--;
+    }
+}
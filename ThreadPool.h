@@ -0,0 +1,39 @@
+#ifndef __THREAD_POOL_H
+#define __THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ *  A fixed set of worker threads running jobs in the order they were submitted.
+ *
+ *  Jobs must not touch GL (the context is only current on the main thread); hand their
+ *  results back to the main thread instead. Jobs still queued when the pool is destroyed
+ *  are dropped, the ones already running are waited for.
+ */
+class ThreadPool {
+private:
+    std::vector<std::thread>            workers;
+    std::deque<std::function<void()>>   jobs;
+    std::mutex                          mutex;
+    std::condition_variable             wake;
+    int                                 busy;           // Workers running a job
+    bool                                stopping;
+
+    void    run();
+
+public:
+    ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    void    submit(const std::function<void()>& job);
+    int     getQueuedCount();
+    int     getThreadCount()            { return (int)workers.size(); }
+};
+
+#endif // !__THREAD_POOL_H
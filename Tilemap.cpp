@@ -0,0 +1,176 @@
+#include "Tilemap.h"
+#include "AssetPack.h"
+#include "World.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+
+Tilemap::Tilemap() {
+    width    = height = 0;
+    tileSize = 1.f;
+}
+
+
+/**
+ *  Makes an empty map
+ *  @param width - Tiles per row
+ *  @param height - Rows
+ *  @param tileSize - Width and height of a tile in world units
+ */
+void Tilemap::create(int width, int height, float tileSize /*= 1.f*/) {
+    this->width    = width;
+    this->height   = height;
+    this->tileSize = tileSize;
+    tiles.assign((size_t)width * height, 0);
+}
+
+
+/**
+ *  Reads the tiles out of a tilemap file's text, the top row first
+ *  @return Whether there was at least one row
+ */
+bool Tilemap::parse(const char* text, size_t size) {
+    std::vector<std::pair<size_t, size_t>> rows;       // Start and length of each line
+    for (size_t start = 0; start < size;) {
+        size_t end = start;
+        while (end < size && text[end] != '\n') end++;
+        size_t length = end - start;
+        if (length > 0 && text[start + length - 1] == '\r') length--;
+        rows.push_back(std::make_pair(start, length));
+        start = end + 1;
+    }
+    while (!rows.empty() && rows.back().second == 0) rows.pop_back();
+    if (rows.empty()) return false;
+
+    size_t columns = 0;
+    for (const std::pair<size_t, size_t>& row : rows)
+        columns = std::max(columns, row.second);
+
+    create((int)columns, (int)rows.size(), tileSize);
+    for (int j = 0; j < height; j++) {
+        const std::pair<size_t, size_t>& row = rows[height - 1 - j];
+        for (size_t i = 0; i < row.second; i++) {
+            char c = text[row.first + i];
+            setSolid((int)i, j, c != '.' && c != ' ');
+        }
+    }
+    return true;
+}
+
+
+/**
+ *  Loads a tilemap file
+ *  @param path - The file, or its name in the pack
+ *  @param tileSize - Width and height of a tile in world units
+ *  @param pack - Looked in before the disk (optional)
+ *  @return Whether the file could be read and had any rows
+ */
+bool Tilemap::load(const std::string& path, float tileSize /*= 1.f*/, const AssetPack* pack /*= nullptr*/) {
+    this->tileSize = tileSize;
+
+    Asset asset;
+    if (pack && pack->find(path, asset)) {
+        if (parse((const char*)asset.data, asset.size)) return true;
+        std::cerr << "Not a valid tilemap: " << path << '\n';
+        return false;
+    }
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cerr << "Could not read tilemap " << path << '\n';
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    std::vector<char> text(fileSize > 0 ? (size_t)fileSize : 0);
+    bool ok = fileSize > 0 && fread(&text[0], 1, text.size(), file) == text.size();
+    fclose(file);
+
+    if (!ok || !parse(&text[0], text.size())) {
+        std::cerr << "Not a valid tilemap: " << path << '\n';
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ *  Traces the outlines of the solid tiles into chains of edges. Each chain runs around one
+ *  solid region (anti-clockwise) or hole (clockwise), with a vertex only where it turns, so
+ *  its edges push out of the solid tiles. Tiles touching only at a corner are kept apart.
+ *  @param edges - Output edges, appended, with the map's bottom-left corner at the origin
+ */
+void Tilemap::buildEdges(std::vector<Shape>& edges) const {
+    // Every side between a solid and an empty tile, going with the solid tile on its left
+    struct Side {
+        int     from, to,           // Grid vertices, y * (width + 1) + x
+                dx, dy;
+    };
+    std::vector<Side> sides;
+    std::vector<int>  outgoing((size_t)(width + 1) * (height + 1) * 2, -1);     // Up to two sides leave a vertex
+
+    auto addSide = [&](int x, int y, int dx, int dy) {
+        Side side = { y * (width + 1) + x, (y + dy) * (width + 1) + x + dx, dx, dy };
+        int* slot = &outgoing[(size_t)side.from * 2];
+        slot[slot[0] == -1 ? 0 : 1] = (int)sides.size();
+        sides.push_back(side);
+    };
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (!isSolid(x, y)) continue;
+            if (!isSolid(x, y - 1)) addSide(x,     y,      1,  0);
+            if (!isSolid(x + 1, y)) addSide(x + 1, y,      0,  1);
+            if (!isSolid(x, y + 1)) addSide(x + 1, y + 1, -1,  0);
+            if (!isSolid(x - 1, y)) addSide(x,     y + 1,  0, -1);
+        }
+    }
+
+    // Follow the sides around each outline, turning left where two leave the same vertex so
+    // the outline stays around the same tile, and keep the vertices where the direction changes
+    std::vector<unsigned char> visited(sides.size(), 0);
+    std::vector<Vec2>          points;
+    for (size_t start = 0; start < sides.size(); start++) {
+        if (visited[start]) continue;
+
+        points.clear();
+        int side = (int)start;
+        do {
+            visited[side] = 1;
+            const Side& s    = sides[side];
+            const int*  slot = &outgoing[(size_t)s.to * 2];
+            int         next = slot[0];
+            if (slot[1] != -1 && s.dx * sides[slot[1]].dy - s.dy * sides[slot[1]].dx > 0) next = slot[1];
+
+            if (sides[next].dx != s.dx || sides[next].dy != s.dy)
+                points.push_back(Vec2((s.to % (width + 1)) * tileSize, (s.to / (width + 1)) * tileSize));
+            side = next;
+        } while (side != (int)start);
+
+        makeChain(&points[0], (int)points.size(), true, edges);
+    }
+}
+
+
+/**
+ *  Adds the map's edges to a world as one static body
+ *  @param world - The world
+ *  @param x - Where the map's bottom-left corner goes
+ *  @param y - Where the map's bottom-left corner goes
+ *  @param friction - Friction of the ground
+ *  @return The body, or -1 if the map has no solid tiles
+ */
+int Tilemap::createBody(World& world, float x /*= 0.f*/, float y /*= 0.f*/, float friction /*= 0.4f*/) const {
+    BodyDef def;
+    buildEdges(def.compound);
+    if (def.compound.empty()) return -1;
+
+    def.dynamic  = false;
+    def.posX     = x;
+    def.posY     = y;
+    def.friction = friction;
+    return world.createBody(def);
+}
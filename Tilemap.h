@@ -0,0 +1,49 @@
+#ifndef __TILEMAP_H
+#define __TILEMAP_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Shape.h"
+
+class AssetPack;
+class World;
+
+
+/**
+ *  A grid of solid and empty tiles, turned into static level geometry.
+ *
+ *  Instead of a box per tile, the outlines of the solid regions are traced into chains of
+ *  one-sided edges (see makeChain()), with the tiles along a straight run merged into one
+ *  long edge. Shapes sliding along a floor then don't catch on the seams between tiles, and
+ *  a level has a handful of edges where it had thousands of boxes. The edges go on one
+ *  static body, whose tree is built once and kept out of the broadphase (see World).
+ *
+ *  Tilemap files are text, one line per row with the top row first: '.' and ' ' are empty,
+ *  anything else is solid.
+ */
+class Tilemap {
+private:
+    std::vector<unsigned char>  tiles;      // 1 for solid, bottom row first
+    int                         width,
+                                height;
+    float                       tileSize;
+
+    bool    parse(const char* text, size_t size);
+
+public:
+    Tilemap();
+
+    void    create(int width, int height, float tileSize = 1.f);
+    bool    load(const std::string& path, float tileSize = 1.f, const AssetPack* pack = nullptr);
+    void    buildEdges(std::vector<Shape>& edges) const;
+    int     createBody(World& world, float x = 0.f, float y = 0.f, float friction = 0.4f) const;
+
+    bool    isSolid(int x, int y) const     { return x >= 0 && y >= 0 && x < width && y < height && tiles[(size_t)y * width + x]; }
+    void    setSolid(int x, int y, bool solid) { tiles[(size_t)y * width + x] = solid ? 1 : 0; }
+    int     getWidth() const                { return width; }
+    int     getHeight() const               { return height; }
+    float   getTileSize() const             { return tileSize; }
+};
+
+#endif // !__TILEMAP_H
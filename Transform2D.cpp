@@ -0,0 +1,97 @@
+#include "Transform2D.h"
+
+#ifdef RBPHYS_SSE2
+#include <emmintrin.h>
+#endif
+
+
+/**
+ *  Composes many transforms at once: out[i] = a[i] * b[i]
+ *  @param a - The outer transforms (e.g. the bodies)
+ *  @param b - The inner transforms (e.g. offsets in the bodies' local space)
+ *  @param out - Output transforms, may alias a or b
+ *  @param count - The number of transforms
+ */
+void composeBatch(const Transform2D* a, const Transform2D* b, Transform2D* out, int count) {
+    int i = 0;
+
+#ifdef RBPHYS_SSE2
+    // One transform is exactly one register: (c, s, x, y)
+    const __m128 sign = _mm_set_ps(1.f, -1.f, 1.f, -1.f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (; i < count; i++) {
+        __m128  A    = _mm_loadu_ps(&a[i].c),
+                B    = _mm_loadu_ps(&b[i].c),
+                aCS  = _mm_shuffle_ps(A, A, _MM_SHUFFLE(1, 0, 1, 0)),           // ac, as, ac, as
+                aSC  = _mm_shuffle_ps(A, A, _MM_SHUFFLE(0, 1, 0, 1)),           // as, ac, as, ac
+                bCX  = _mm_shuffle_ps(B, B, _MM_SHUFFLE(2, 2, 0, 0)),           // bc, bc, bx, bx
+                bSY  = _mm_mul_ps(_mm_shuffle_ps(B, B, _MM_SHUFFLE(3, 3, 1, 1)), sign), // -bs, bs, -by, by
+                aXY  = _mm_shuffle_ps(zero, A, _MM_SHUFFLE(3, 2, 0, 0)),        // 0, 0, ax, ay
+                r    = _mm_add_ps(_mm_add_ps(_mm_mul_ps(aCS, bCX), _mm_mul_ps(aSC, bSY)), aXY);
+        _mm_storeu_ps(&out[i].c, r);
+    }
+#endif
+
+    for (; i < count; i++)
+        out[i] = mul(a[i], b[i]);
+}
+
+
+/**
+ *  Computes the cosine and sine of many angles at once.
+ *  The SSE2 path reduces the angles to [-pi/4, pi/4] and evaluates minimax polynomials
+ *  for four angles per iteration (accurate to a couple of ulp for reasonable angles).
+ *  @param angles - The angles in radians
+ *  @param c - Output cosines
+ *  @param s - Output sines
+ *  @param count - The number of angles
+ */
+void sincosBatch(const float* angles, float* c, float* s, int count) {
+    int i = 0;
+
+#ifdef RBPHYS_SSE2
+    const __m128    twoOverPi = _mm_set1_ps(0.636619772f),
+                    dp1       = _mm_set1_ps(1.5703125f),                // pi/2 split in three parts,
+                    dp2       = _mm_set1_ps(4.837512969970703125e-4f),  // so the reduction stays exact
+                    dp3       = _mm_set1_ps(7.54978995489188216e-8f),
+                    s1 = _mm_set1_ps(-1.6666654611e-1f), s2 = _mm_set1_ps(8.3321608736e-3f),  s3 = _mm_set1_ps(-1.9515295891e-4f),
+                    c1 = _mm_set1_ps( 4.166664568e-2f),  c2 = _mm_set1_ps(-1.388731625e-3f),  c3 = _mm_set1_ps(2.443315711e-5f),
+                    half = _mm_set1_ps(0.5f),
+                    one  = _mm_set1_ps(1.f);
+    const __m128i   i1 = _mm_set1_epi32(1),
+                    i2 = _mm_set1_epi32(2);
+
+    for (; i + 4 <= count; i += 4) {
+        // Find the quadrant and reduce the angle into it
+        __m128  x  = _mm_loadu_ps(angles + i);
+        __m128i j  = _mm_cvtps_epi32(_mm_mul_ps(x, twoOverPi));
+        __m128  jf = _mm_cvtepi32_ps(j),
+                y  = _mm_sub_ps(x, _mm_mul_ps(jf, dp1));
+        y = _mm_sub_ps(y, _mm_mul_ps(jf, dp2));
+        y = _mm_sub_ps(y, _mm_mul_ps(jf, dp3));
+
+        // Polynomials for sin and cos on [-pi/4, pi/4]
+        __m128  y2 = _mm_mul_ps(y, y),
+                sp = _mm_add_ps(y, _mm_mul_ps(_mm_mul_ps(y, y2),
+                        _mm_add_ps(s1, _mm_mul_ps(y2, _mm_add_ps(s2, _mm_mul_ps(y2, s3)))))),
+                cp = _mm_add_ps(_mm_sub_ps(one, _mm_mul_ps(half, y2)), _mm_mul_ps(_mm_mul_ps(y2, y2),
+                        _mm_add_ps(c1, _mm_mul_ps(y2, _mm_add_ps(c2, _mm_mul_ps(y2, c3))))));
+
+        // Odd quadrants swap sin and cos, and the sign depends on the quadrant
+        __m128  swap    = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, i1), i1)),
+                sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, i2), 30)),
+                cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(j, i1), i2), 30)),
+                sinV    = _mm_or_ps(_mm_and_ps(swap, cp), _mm_andnot_ps(swap, sp)),
+                cosV    = _mm_or_ps(_mm_and_ps(swap, sp), _mm_andnot_ps(swap, cp));
+
+        _mm_storeu_ps(s + i, _mm_xor_ps(sinV, sinSign));
+        _mm_storeu_ps(c + i, _mm_xor_ps(cosV, cosSign));
+    }
+#endif
+
+    for (; i < count; i++) {
+        c[i] = cos(angles[i]);
+        s[i] = sin(angles[i]);
+    }
+}
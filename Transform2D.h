@@ -0,0 +1,90 @@
+#ifndef __TRANSFORM2D_H
+#define __TRANSFORM2D_H
+
+#include "Math2D.h"
+
+
+/**
+ *  A rigid 2D transform: a rotation stored as cos/sin, followed by a translation.
+ *  The members are laid out as one 16-byte vector (c, s, x, y) so batches can be composed with SIMD.
+ */
+struct Transform2D {
+    float   c, s,       // Cosine and sine of the angle
+            x, y;       // Translation
+
+    Transform2D() : c(1.f), s(0.f), x(0.f), y(0.f) {}
+    Transform2D(float x, float y, float angle) : c(cos(angle)), s(sin(angle)), x(x), y(y) {}
+    Transform2D(float c, float s, float x, float y) : c(c), s(s), x(x), y(y) {}
+
+    Vec2    getPosition() const     { return Vec2(x, y); }
+    float   getAngle() const        { return atan2(s, c); }
+};
+
+
+/**
+ *  Transforms a point from local to world space
+ */
+inline Vec2 mul(const Transform2D& t, const Vec2& v) {
+    return Vec2(t.c * v.x - t.s * v.y + t.x, t.s * v.x + t.c * v.y + t.y);
+}
+
+
+/**
+ *  Transforms a point from world to local space
+ */
+inline Vec2 mulT(const Transform2D& t, const Vec2& v) {
+    float   px = v.x - t.x,
+            py = v.y - t.y;
+    return Vec2(t.c * px + t.s * py, -t.s * px + t.c * py);
+}
+
+
+/**
+ *  Gets the world-space box around a local-space box
+ */
+inline AABB mul(const Transform2D& t, const AABB& box) {
+    Vec2    center = mul(t, 0.5f * (box.lower + box.upper)),
+            half   = 0.5f * (box.upper - box.lower),
+            extent = Vec2(std::fabs(t.c) * half.x + std::fabs(t.s) * half.y,
+                          std::fabs(t.s) * half.x + std::fabs(t.c) * half.y);
+    AABB result = { center - extent, center + extent };
+    return result;
+}
+
+
+/**
+ *  Gets the local-space box around a world-space box
+ */
+inline AABB mulT(const Transform2D& t, const AABB& box) {
+    Vec2 origin = mulT(t, Vec2());
+    return mul(Transform2D(t.c, -t.s, origin.x, origin.y), box);
+}
+
+
+/**
+ *  Composes two transforms, the result applies b first and then a
+ */
+inline Transform2D mul(const Transform2D& a, const Transform2D& b) {
+    Transform2D t;
+    t.c = a.c * b.c - a.s * b.s;
+    t.s = a.s * b.c + a.c * b.s;
+    t.x = a.c * b.x - a.s * b.y + a.x;
+    t.y = a.s * b.x + a.c * b.y + a.y;
+    return t;
+}
+
+
+/**
+ *  Writes the transform, scaled by (sx, sy), as a column-major 3x2 matrix for glUniformMatrix3x2fv.
+ *  That's 6 floats per transform instead of the 16 in a mat4.
+ */
+inline void toMat3x2(const Transform2D& t, float sx, float sy, float out[6]) {
+    out[0] =  t.c * sx;     out[1] = t.s * sx;      // First column
+    out[2] = -t.s * sy;     out[3] = t.c * sy;      // Second column
+    out[4] =  t.x;          out[5] = t.y;           // Translation
+}
+
+void composeBatch(const Transform2D* a, const Transform2D* b, Transform2D* out, int count);
+void sincosBatch (const float* angles, float* c, float* s, int count);
+
+#endif // !__TRANSFORM2D_H
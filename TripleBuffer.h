@@ -0,0 +1,59 @@
+#ifndef __TRIPLE_BUFFER_H
+#define __TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+#define TRIPLE_BUFFER_INDEX 0x3u        // Bits of the shared slot's index
+#define TRIPLE_BUFFER_FRESH 0x4u        // Set when the shared slot holds data the reader hasn't taken
+
+
+/**
+ *  Hands values from one writer thread to one reader thread without locks or waiting.
+ *
+ *  The writer fills the back slot and publishes it by swapping it with the shared slot;
+ *  the reader takes the shared slot by swapping it with its front slot. Neither ever
+ *  touches the other's slot, so the reader always sees a complete value, and values
+ *  published faster than they're read are simply skipped. Slots are reused, so the
+ *  writer should overwrite its back slot in place rather than reallocate it.
+ */
+template <typename T>
+class TripleBuffer {
+private:
+    T                       slots[3];
+    std::atomic<uint32_t>   shared;     // Index of the shared slot | TRIPLE_BUFFER_FRESH
+    uint32_t                back;       // Only touched by the writer
+    uint32_t                front;      // Only touched by the reader
+
+public:
+    TripleBuffer() : shared(1), back(0), front(2) {}
+
+    /**
+     *  Gets the slot to write the next value to (writer thread)
+     */
+    T& getBack() { return slots[back]; }
+
+    /**
+     *  Makes the back slot the newest value, and gets a free slot to write the next one to (writer thread)
+     */
+    void publish() {
+        back = shared.exchange(back | TRIPLE_BUFFER_FRESH, std::memory_order_acq_rel) & TRIPLE_BUFFER_INDEX;
+    }
+
+    /**
+     *  Takes the newest published value, if there is one that wasn't taken yet (reader thread)
+     *  @return Whether the front slot changed
+     */
+    bool update() {
+        if (!(shared.load(std::memory_order_relaxed) & TRIPLE_BUFFER_FRESH)) return false;
+        front = shared.exchange(front, std::memory_order_acq_rel) & TRIPLE_BUFFER_INDEX;
+        return true;
+    }
+
+    /**
+     *  Gets the value taken by the last update() (reader thread)
+     */
+    const T& getFront() { return slots[front]; }
+};
+
+#endif // !__TRIPLE_BUFFER_H
@@ -1,4 +1,5 @@
 #include "Window.h"
+#include "GLState.h"
 
 
 /**
@@ -56,7 +57,7 @@ void Window::update(bool k_f) {
         
     // Change context (if legible)
     if (k_f) glfwMakeContextCurrent(window);
-    glEnable(GL_MULTISAMPLE); // Enable anti-aliasing
+    GLState::enable(GL_MULTISAMPLE); // Enable anti-aliasing
 
     // Resize window
     int windowX, windowY;
@@ -0,0 +1,567 @@
+#include "World.h"
+#include "Collision.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+/**
+ *  Creates an empty world
+ *  @param gravityX - Gravity along the x-axis
+ *  @param gravityY - Gravity along the y-axis
+ */
+World::World(float gravityX /*= 0.f*/, float gravityY /*= -9.81f*/) {
+    this->gravityX = gravityX;
+    this->gravityY = gravityY;
+    iterations = 8;
+    sleeping   = true;
+    perf       = nullptr;
+}
+
+
+// Bodies slower than this for TIME_TO_SLEEP seconds are put to sleep, together with everything they touch
+#define SLEEP_LINEAR_TOLERANCE  0.01f
+#define SLEEP_ANGULAR_TOLERANCE 0.035f
+#define TIME_TO_SLEEP           0.5f
+
+// Compounds with more shapes than this get one proxy and a tree instead of a proxy per shape
+#define COMPOUND_PROXY_LIMIT    8
+
+
+/**
+ *  Adds a body to the world
+ *  @param def - Description of the body
+ *  @return The index of the body
+ */
+int World::createBody(const BodyDef& def) {
+    int body = getBodyCount();
+
+    const Shape* parts = def.compound.empty() ? &def.shape : &def.compound[0];
+    int          count = def.compound.empty() ? 1 : (int)def.compound.size();
+
+    // Mass properties. Static bodies keep their centre at the origin.
+    MassData massData = MassData();
+    if (def.dynamic)
+        massData = def.massData.mass > 0.f ? def.massData : computeMassData(parts, count, def.density);
+    float mass = massData.mass, inertia = massData.inertia;
+
+    // Hot state, placed by the centre of mass
+    float c = cos(def.angle), s = sin(def.angle);
+    Vec2  center = Vec2(def.posX, def.posY) + rotate(massData.center, c, s);
+    motion.posX.push_back(center.x);
+    motion.posY.push_back(center.y);
+    motion.angle.push_back(def.angle);
+    motion.rotC.push_back(c);
+    motion.rotS.push_back(s);
+    motion.localCenterX.push_back(massData.center.x);
+    motion.localCenterY.push_back(massData.center.y);
+
+    velocity.velX.push_back(def.dynamic ? def.velX : 0.f);
+    velocity.velY.push_back(def.dynamic ? def.velY : 0.f);
+    velocity.angVel.push_back(def.dynamic ? def.angVel : 0.f);
+    velocity.invMass.push_back(mass > 0.f ? 1.f / mass : 0.f);
+    velocity.invInertia.push_back(inertia > 0.f ? 1.f / inertia : 0.f);
+    velocity.awake.push_back(def.dynamic ? 1 : 0);
+
+    // Cold state
+    cold.userData.push_back(def.userData);
+    cold.filterCategory.push_back(def.filterCategory);
+    cold.filterMask.push_back(def.filterMask);
+    cold.friction.push_back(def.friction);
+    cold.restitution.push_back(def.restitution);
+    cold.mass.push_back(mass);
+    cold.inertia.push_back(inertia);
+    cold.sleepTime.push_back(0.f);
+    cold.islandNext.push_back(-1);
+
+    cold.firstShape.push_back((int)shapes.size());
+    cold.shapeCount.push_back(count);
+    shapes.insert(shapes.end(), parts, parts + count);
+
+    // Broadphase proxies: one per shape, or one around a big compound and a tree over its shapes.
+    // Static bodies with a tree, like level geometry, get no proxy and are searched directly.
+    Transform2D xf = getTransform(body);
+    cold.firstProxy.push_back(broadphase.getProxyCount());
+    cold.tree.push_back(-1);
+    if (count > COMPOUND_PROXY_LIMIT) {
+        std::vector<AABB> boxes(count);
+        for (int i = 0; i < count; i++)
+            boxes[i] = computeAABB(parts[i], Transform2D());
+        cold.tree[body] = (int)trees.size();
+        trees.push_back(StaticTree());
+        trees.back().build(&boxes[0], count, 1);
+        if (def.dynamic) {
+            broadphase.createProxy(mul(xf, trees.back().getBounds()), body);
+            proxyShape.push_back(-1);
+        } else {
+            staticTrees.push_back(body);
+        }
+    } else {
+        for (int i = 0; i < count; i++) {
+            broadphase.createProxy(computeAABB(parts[i], xf), body);
+            proxyShape.push_back(cold.firstShape[body] + i);
+        }
+    }
+    cold.proxyCount.push_back(broadphase.getProxyCount() - cold.firstProxy[body]);
+
+    return body;
+}
+
+
+/**
+ *  Connects two bodies with a revolute joint
+ *  @param bodyA - The first body
+ *  @param bodyB - The second body
+ *  @param anchorX - The x-position of the pivot in world space
+ *  @param anchorY - The y-position of the pivot in world space
+ *  @return The index of the joint
+ */
+int World::createJoint(int bodyA, int bodyB, float anchorX, float anchorY) {
+    Vec2 anchor(anchorX, anchorY);
+    wake(bodyA);
+    wake(bodyB);
+    return joints.add(bodyA, bodyB,
+                      mulT(getMassTransform(bodyA), anchor),
+                      mulT(getMassTransform(bodyB), anchor));
+}
+
+
+/**
+ *  Wakes a body and the rest of the island it fell asleep with
+ *  @param body - The body
+ */
+void World::wake(int body) {
+    if (velocity.invMass[body] == 0.f || velocity.awake[body]) return;
+
+    // Walk the circular list of the island
+    int i = body;
+    do {
+        int next = cold.islandNext[i];
+        velocity.awake[i]    = 1;
+        cold.sleepTime[i]    = 0.f;
+        cold.islandNext[i]   = -1;
+        i = next;
+    } while (i != body && i != -1);
+}
+
+
+/**
+ *  Counts the bodies that are awake
+ */
+int World::getAwakeBodyCount() {
+    int count = 0;
+    for (unsigned char awake : velocity.awake)
+        count += awake;
+    return count;
+}
+
+
+/**
+ *  Gets the transform of a body's origin, found from its centre of mass
+ */
+Transform2D World::getTransform(int body) {
+    float c = motion.rotC[body], s = motion.rotS[body];
+    Vec2  origin = Vec2(motion.posX[body], motion.posY[body])
+                 - rotate(Vec2(motion.localCenterX[body], motion.localCenterY[body]), c, s);
+    return Transform2D(c, s, origin.x, origin.y);
+}
+
+
+/**
+ *  Teleports a body
+ *  @param body - The body
+ *  @param x - The new x-position of its origin
+ *  @param y - The new y-position of its origin
+ *  @param angle - The new angle (radians)
+ */
+void World::setTransform(int body, float x, float y, float angle) {
+    float c = cos(angle), s = sin(angle);
+    Vec2  center = Vec2(x, y) + rotate(Vec2(motion.localCenterX[body], motion.localCenterY[body]), c, s);
+    motion.posX[body]  = center.x;
+    motion.posY[body]  = center.y;
+    motion.angle[body] = angle;
+    motion.rotC[body]  = c;
+    motion.rotS[body]  = s;
+    moveProxies(body);
+    wake(body);
+}
+
+
+/**
+ *  Gets the transforms of all bodies' origins (where their sprites are centred),
+ *  optionally composed with a local transform per body
+ *  @param out - Output array with room for getBodyCount() transforms
+ *  @param local - Transforms in each body's local space (e.g. a sprite's offset), or nullptr
+ */
+void World::getTransforms(Transform2D* out, const Transform2D* local /*= nullptr*/) {
+    int n = getBodyCount();
+    for (int i = 0; i < n; i++)
+        out[i] = getTransform(i);
+
+    if (local)
+        composeBatch(out, local, out, n);
+}
+
+
+/**
+ *  Sets the velocity of a body. Does nothing for static bodies.
+ */
+void World::setVelocity(int body, float vx, float vy, float angVel) {
+    if (velocity.invMass[body] == 0.f) return;
+    wake(body);
+    velocity.velX[body]   = vx;
+    velocity.velY[body]   = vy;
+    velocity.angVel[body] = angVel;
+}
+
+
+/**
+ *  Applies an impulse at the body's centre of mass
+ */
+void World::applyImpulse(int body, float ix, float iy) {
+    wake(body);
+    velocity.velX[body] += velocity.invMass[body] * ix;
+    velocity.velY[body] += velocity.invMass[body] * iy;
+}
+
+
+/**
+ *  Advances the simulation
+ *  @param dt - The timestep in seconds
+ */
+void World::step(float dt) {
+    if (dt <= 0.f) return;
+    PROFILE_ZONE("World::step");
+
+    {
+        PROFILE_ZONE("broadphase");
+        PerfScope perfScope(perf, PERF_BROADPHASE);
+        updateBroadphase();
+    }
+    {
+        PROFILE_ZONE("narrowphase");
+        PerfScope perfScope(perf, PERF_NARROWPHASE);
+        collide();
+    }
+    {
+        PROFILE_ZONE("solve");
+        PerfScope perfScope(perf, PERF_SOLVE);
+        integrateVelocities(dt);
+
+        solver.prepare(velocity, dt);
+        joints.prepare(motion, velocity, dt);
+        for (int i = 0; i < iterations; i++) {
+            joints.solve(velocity);
+            solver.solve(velocity);
+        }
+    }
+    {
+        PROFILE_ZONE("integrate");
+        PerfScope perfScope(perf, PERF_INTEGRATE);
+        integratePositions(dt);
+    }
+    {
+        PROFILE_ZONE("sleep");
+        PerfScope perfScope(perf, PERF_SLEEP);
+        updateSleep(dt);
+    }
+}
+
+
+/**
+ *  Moves the broadphase proxies to the bodies' current bounds
+ */
+void World::updateBroadphase() {
+    int n = getBodyCount();
+    for (int i = 0; i < n; i++) {
+        if (!velocity.awake[i]) continue;
+        moveProxies(i);
+    }
+    broadphase.findPairs(pairs);
+}
+
+
+/**
+ *  Moves a body's proxies to its shapes' current bounds. A compound with a tree gets the
+ *  box around its tree's bounds, which is looser but doesn't depend on its shape count.
+ */
+void World::moveProxies(int body) {
+    Transform2D xf = getTransform(body);
+    if (cold.tree[body] != -1) {
+        if (cold.proxyCount[body] > 0)
+            broadphase.moveProxy(cold.firstProxy[body], mul(xf, trees[cold.tree[body]].getBounds()));
+        return;
+    }
+    for (int proxy = cold.firstProxy[body]; proxy < cold.firstProxy[body] + cold.proxyCount[body]; proxy++)
+        broadphase.moveProxy(proxy, computeAABB(shapes[proxyShape[proxy]], xf));
+}
+
+
+/**
+ *  Runs the narrowphase on the broadphase pairs and creates the contact constraints
+ */
+void World::collide() {
+    solver.begin();
+
+    // Joints wake their partners before any contacts are made. Static bodies are never
+    // awake, so joints to them are left out or the other body could never sleep.
+    for (int i = 0; i < joints.getCount(); i++) {
+        RevoluteJoint& joint = joints.getJoint(i);
+        if (velocity.invMass[joint.bodyA] == 0.f || velocity.invMass[joint.bodyB] == 0.f) continue;
+        if (velocity.awake[joint.bodyA] != velocity.awake[joint.bodyB]) {
+            wake(joint.bodyA);
+            wake(joint.bodyB);
+        }
+    }
+
+    // A contact with a sleeping body wakes its island (see addContact()). Pairs of sleeping
+    // bodies are put aside and gone through again until no more islands wake up, so the
+    // contacts inside an island that woke up late in the list are still made this step.
+    sleepingPairs.clear();
+    for (const ProxyPair& pair : pairs) {
+        if (!collidePair(pair)) sleepingPairs.push_back(pair);
+    }
+    for (size_t asleep = 0; asleep != sleepingPairs.size();) {
+        asleep = sleepingPairs.size();
+        size_t kept = 0;
+        for (size_t i = 0; i < asleep; i++) {
+            if (!collidePair(sleepingPairs[i])) sleepingPairs[kept++] = sleepingPairs[i];
+        }
+        sleepingPairs.resize(kept);
+    }
+
+    // Static trees (e.g. a tilemap's edges) aren't in the broadphase: the proxies of the awake
+    // bodies are looked up in them instead
+    int n = getBodyCount();
+    for (int s : staticTrees) {
+        AABB bounds = mul(getTransform(s), trees[cold.tree[s]].getBounds());
+        for (int b = 0; b < n; b++) {
+            if (!velocity.awake[b]) continue;
+            if (!(cold.filterCategory[s] & cold.filterMask[b]) || !(cold.filterCategory[b] & cold.filterMask[s])) continue;
+
+            for (int proxy = cold.firstProxy[b]; proxy < cold.firstProxy[b] + cold.proxyCount[b]; proxy++) {
+                if (overlaps(bounds, broadphase.getAABB(proxy)))
+                    collideProxies(s, -1, bounds, b, proxyShape[proxy], broadphase.getAABB(proxy));
+            }
+        }
+    }
+}
+
+
+/**
+ *  Makes the contacts of a broadphase pair
+ *  @return False when both bodies are asleep and nothing was done
+ */
+bool World::collidePair(const ProxyPair& pair) {
+    int proxyA = pair.proxyA,
+        proxyB = pair.proxyB,
+        a      = broadphase.getUserData(proxyA),
+        b      = broadphase.getUserData(proxyB);
+    if (a == b) return true;        // Shapes of the same body
+    if (a > b) { std::swap(a, b); std::swap(proxyA, proxyB); }
+
+    // Only pairs with an awake body need contacts (static bodies are never awake)
+    if (!velocity.awake[a] && !velocity.awake[b]) return false;
+
+    // Collision filtering
+    if (!(cold.filterCategory[a] & cold.filterMask[b]) || !(cold.filterCategory[b] & cold.filterMask[a])) return true;
+
+    collideProxies(a, proxyShape[proxyA], broadphase.getAABB(proxyA), b, proxyShape[proxyB], broadphase.getAABB(proxyB));
+    return true;
+}
+
+
+/**
+ *  Makes the contacts between the shapes of two bodies' overlapping proxies
+ *  @param a - The first body
+ *  @param shapeA - The shape of the first body's proxy, -1 to search the body's tree
+ *  @param boundsA - The bounds of the first body's proxy
+ *  @param b - The second body
+ *  @param shapeB - The shape of the second body's proxy, -1 to search the body's tree
+ *  @param boundsB - The bounds of the second body's proxy
+ */
+void World::collideProxies(int a, int shapeA, const AABB& boundsA, int b, int shapeB, const AABB& boundsB) {
+    Transform2D xfA = getTransform(a),
+                xfB = getTransform(b);
+    if (shapeA != -1 && shapeB != -1) {
+        addContact(a, shapeA, xfA, b, shapeB, xfB);
+        return;
+    }
+
+    // A compound's shapes are found in its tree, with the other side's bounds moved into its space
+    if (shapeB != -1) {
+        trees[cold.tree[a]].query(mulT(xfA, boundsB), [&](int child) {
+            addContact(a, cold.firstShape[a] + child, xfA, b, shapeB, xfB);
+        });
+    } else if (shapeA != -1) {
+        trees[cold.tree[b]].query(mulT(xfB, boundsA), [&](int child) {
+            addContact(a, shapeA, xfA, b, cold.firstShape[b] + child, xfB);
+        });
+    } else {
+        const StaticTree& treeB = trees[cold.tree[b]];
+        trees[cold.tree[a]].query(mulT(xfA, boundsB), [&](int childA) {
+            int shape = cold.firstShape[a] + childA;
+            treeB.query(mulT(xfB, computeAABB(shapes[shape], xfA)), [&](int childB) {
+                addContact(a, shape, xfA, b, cold.firstShape[b] + childB, xfB);
+            });
+        });
+    }
+}
+
+
+/**
+ *  Collides two shapes of different bodies and turns their manifold into a contact constraint
+ *  @param a - The first body
+ *  @param shapeA - A shape of the first body
+ *  @param xfA - The transform of the first body
+ *  @param b - The second body
+ *  @param shapeB - A shape of the second body
+ *  @param xfB - The transform of the second body
+ */
+void World::addContact(int a, int shapeA, const Transform2D& xfA, int b, int shapeB, const Transform2D& xfB) {
+    Manifold manifold;
+    ::collide(shapes[shapeA], xfA, shapes[shapeB], xfB, manifold);
+    if (manifold.count == 0) return;
+
+    // Touching wakes up a sleeping body, and its island with it
+    if (!velocity.awake[a]) wake(a);
+    if (!velocity.awake[b]) wake(b);
+
+    ContactConstraint& c = solver.add();
+    c.key         = ((unsigned long long)shapeA << 32) | (unsigned long long)shapeB;
+    c.bodyA       = a;
+    c.bodyB       = b;
+    c.normal      = manifold.normal;
+    c.friction    = std::sqrt(cold.friction[a] * cold.friction[b]);
+    c.restitution = std::max(cold.restitution[a], cold.restitution[b]);
+    c.count       = manifold.count;
+    Vec2 centerA(motion.posX[a], motion.posY[a]),
+         centerB(motion.posX[b], motion.posY[b]);
+    for (int i = 0; i < manifold.count; i++) {
+        c.points[i].rA         = manifold.points[i].point - centerA;
+        c.points[i].rB         = manifold.points[i].point - centerB;
+        c.points[i].separation = manifold.points[i].separation;
+        c.points[i].id         = manifold.points[i].id;
+    }
+}
+
+
+/**
+ *  Applies gravity to the dynamic bodies
+ */
+void World::integrateVelocities(float dt) {
+    int     n  = getBodyCount();
+    float   gx = gravityX * dt,
+            gy = gravityY * dt;
+
+    float               *vx    = velocity.velX.data(),
+                        *vy    = velocity.velY.data();
+    const unsigned char *awake = velocity.awake.data();
+
+    for (int i = 0; i < n; i++) {
+        if (!awake[i]) continue;
+        vx[i] += gx;
+        vy[i] += gy;
+    }
+}
+
+
+/**
+ *  Moves the bodies along their velocities (semi-implicit euler),
+ *  and refreshes the cached rotations so nothing else has to call sin/cos this step
+ */
+void World::integratePositions(float dt) {
+    int n = getBodyCount();
+
+    float       *px = motion.posX.data(),
+                *py = motion.posY.data(),
+                *pa = motion.angle.data();
+    const float *vx = velocity.velX.data(),
+                *vy = velocity.velY.data(),
+                *va = velocity.angVel.data();
+
+    for (int i = 0; i < n; i++) {
+        px[i] += vx[i] * dt;
+        py[i] += vy[i] * dt;
+        pa[i] += va[i] * dt;
+    }
+
+    sincosBatch(pa, motion.rotC.data(), motion.rotS.data(), n);
+}
+
+
+/**
+ *  Finds the root of a body's island (union-find with path halving)
+ */
+int World::findIsland(int body) {
+    while (islandParent[body] != body) {
+        islandParent[body] = islandParent[islandParent[body]];
+        body = islandParent[body];
+    }
+    return body;
+}
+
+
+/**
+ *  Puts islands of bodies to sleep when all of their bodies have been at rest long enough
+ *  @param dt - The timestep
+ */
+void World::updateSleep(float dt) {
+    if (!sleeping) return;
+
+    int n = getBodyCount();
+    float linTol = SLEEP_LINEAR_TOLERANCE * SLEEP_LINEAR_TOLERANCE,
+          angTol = SLEEP_ANGULAR_TOLERANCE * SLEEP_ANGULAR_TOLERANCE;
+
+    // Update the rest timers
+    for (int i = 0; i < n; i++) {
+        if (!velocity.awake[i]) continue;
+        float v2 = velocity.velX[i] * velocity.velX[i] + velocity.velY[i] * velocity.velY[i],
+              w2 = velocity.angVel[i] * velocity.angVel[i];
+        cold.sleepTime[i] = (v2 > linTol || w2 > angTol) ? 0.f : cold.sleepTime[i] + dt;
+    }
+
+    // Join bodies connected by touching contacts or joints into islands
+    islandParent.resize(n);
+    for (int i = 0; i < n; i++)
+        islandParent[i] = i;
+
+    auto join = [this](int a, int b) {
+        if (!velocity.awake[a] || !velocity.awake[b]) return;
+        a = findIsland(a);
+        b = findIsland(b);
+        if (a != b) islandParent[a] = b;
+    };
+    for (int i = 0; i < solver.getCount(); i++) {
+        const ContactConstraint& c = solver.getConstraint(i);
+        join(c.bodyA, c.bodyB);
+    }
+    for (int i = 0; i < joints.getCount(); i++)
+        join(joints.getJoint(i).bodyA, joints.getJoint(i).bodyB);
+
+    // An island's rest time is the shortest one of its bodies
+    std::vector<float> islandTime(n, TIME_TO_SLEEP);
+    for (int i = 0; i < n; i++) {
+        if (!velocity.awake[i]) continue;
+        int root = findIsland(i);
+        islandTime[root] = std::min(islandTime[root], cold.sleepTime[i]);
+    }
+
+    // Put the islands that have rested long enough to sleep, linking their bodies in a circular list
+    std::vector<int> islandFirst(n, -1), islandLast(n, -1);
+    for (int i = 0; i < n; i++) {
+        if (!velocity.awake[i]) continue;
+        int root = findIsland(i);
+        if (islandTime[root] < TIME_TO_SLEEP) continue;
+
+        velocity.awake[i]  = 0;
+        velocity.velX[i]   = velocity.velY[i] = velocity.angVel[i] = 0.f;
+        if (islandFirst[root] == -1) islandFirst[root] = i;
+        else                         cold.islandNext[islandLast[root]] = i;
+        islandLast[root] = i;
+    }
+    for (int root = 0; root < n; root++)
+        if (islandFirst[root] != -1)
+            cold.islandNext[islandLast[root]] = islandFirst[root];
+}
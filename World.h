@@ -0,0 +1,102 @@
+#ifndef __WORLD_H
+#define __WORLD_H
+
+#include "Body.h"
+#include "Broadphase.h"
+#include "ContactSolver.h"
+#include "JointSolver.h"
+#include "PerfCounters.h"
+#include "StaticTree.h"
+
+#include <vector>
+
+
+/**
+ *  Holds all rigid bodies and steps the simulation.
+ *
+ *  Body state is split by how often it is touched: the integrator streams through
+ *  BodyMotion and BodyVelocity, the solver only through BodyVelocity, and everything
+ *  else lives in BodyCold so it doesn't pollute the cache in the inner loops.
+ *
+ *  A body can have several shapes (a compound). Small compounds get a broadphase proxy per
+ *  shape; bigger ones get one proxy for the whole body and a tree over their shapes, which
+ *  the narrowphase searches, so they don't flood the broadphase with pairs. Static bodies
+ *  with a tree (e.g. a tilemap's edges) have no proxy at all; awake bodies' proxies are looked
+ *  up in their trees instead, so level geometry never goes through the sweep.
+ */
+class World {
+private:
+    BodyMotion              motion;         // Hot: positions and angles
+    BodyVelocity            velocity;       // Hot: velocities and inverse mass/inertia
+    BodyCold                cold;           // Cold: metadata
+    std::vector<Shape>      shapes;         // Collision shapes, each body's next to each other
+    std::vector<StaticTree> trees;          // Trees over the shapes of big compounds, in body space
+    std::vector<int>        staticTrees;    // Static bodies with a tree, kept out of the broadphase
+
+    Broadphase              broadphase;
+    std::vector<int>        proxyShape;     // Shape of each proxy, -1 for a proxy around a whole compound
+    std::vector<ProxyPair>  pairs;
+    std::vector<ProxyPair>  sleepingPairs;  // Scratch space for the pairs put aside by collide()
+    ContactSolver           solver;
+    JointSolver             joints;
+
+    float                   gravityX,
+                            gravityY;
+    int                     iterations;     // Velocity iterations per step
+    bool                    sleeping;       // Whether bodies at rest are put to sleep
+    std::vector<int>        islandParent;   // Scratch space for finding islands
+    PerfCounters*           perf;           // Hardware counters per phase, or null
+
+    void    updateBroadphase();
+    void    moveProxies(int body);
+    void    collide();
+    bool    collidePair(const ProxyPair& pair);
+    void    collideProxies(int a, int shapeA, const AABB& boundsA, int b, int shapeB, const AABB& boundsB);
+    void    addContact(int a, int shapeA, const Transform2D& xfA, int b, int shapeB, const Transform2D& xfB);
+    void    integrateVelocities(float dt);
+    void    integratePositions(float dt);
+    void    updateSleep(float dt);
+    int     findIsland(int body);
+
+    Transform2D getMassTransform(int body)  { return Transform2D(motion.rotC[body], motion.rotS[body], motion.posX[body], motion.posY[body]); }
+
+public:
+    World(float gravityX = 0.f, float gravityY = -9.81f);
+
+    int     createBody(const BodyDef& def);
+    int     createJoint(int bodyA, int bodyB, float anchorX, float anchorY);
+    void    step(float dt);
+    void    wake(int body);
+
+    int     getBodyCount()                  { return (int)motion.posX.size(); }
+    int     getContactCount()               { return solver.getCount(); }
+    int     getJointCount()                 { return joints.getCount(); }
+    int     getAwakeBodyCount();
+    bool    isAwake(int body)               { return velocity.awake[body] != 0; }
+    float   getPositionX(int body)          { return getTransform(body).x; }
+    float   getPositionY(int body)          { return getTransform(body).y; }
+    float   getAngle(int body)              { return motion.angle[body]; }
+    Vec2    getCenterOfMass(int body)       { return Vec2(motion.posX[body], motion.posY[body]); }
+    Vec2    getLocalCenter(int body)        { return Vec2(motion.localCenterX[body], motion.localCenterY[body]); }
+    float   getVelocityX(int body)          { return velocity.velX[body]; }
+    float   getVelocityY(int body)          { return velocity.velY[body]; }
+    float   getAngularVelocity(int body)    { return velocity.angVel[body]; }
+    float   getMass(int body)               { return cold.mass[body]; }
+    float   getInertia(int body)            { return cold.inertia[body]; }
+    void*   getUserData(int body)           { return cold.userData[body]; }
+    const Shape& getShape(int body, int i = 0) { return shapes[cold.firstShape[body] + i]; }
+    int     getShapeCount(int body)         { return cold.shapeCount[body]; }
+    Transform2D getTransform(int body);
+    void    getTransforms(Transform2D* out, const Transform2D* local = nullptr);
+
+    void    setGravity(float x, float y)    { gravityX = x; gravityY = y; }
+    void    setIterations(int iterations)   { this->iterations = iterations; }
+    void    setSleepingEnabled(bool enabled){ sleeping = enabled; }
+    void    setPerfCounters(PerfCounters* counters) { perf = counters; }
+
+    void    setTransform(int body, float x, float y, float angle);
+    void    setVelocity(int body, float vx, float vy, float angVel);
+    void    applyImpulse(int body, float ix, float iy);
+};
+
+#endif // !__WORLD_H
@@ -0,0 +1,520 @@
+#include "World.h"
+#include "Tilemap.h"
+#include "Profiler.h"
+#include "PerfCounters.h"
+#include "Stats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+
+/**
+ *  A canonical stress scene
+ */
+struct BenchScene {
+    const char* name;
+    void        (*build)(World& world);
+    int         steps;                      // Default number of steps to run
+};
+
+
+/**
+ *  The measurements of one scene
+ */
+struct BenchResult {
+    std::string name;
+    int         bodies,
+                joints,
+                steps,
+                awakeAtEnd;
+    double      buildMs,
+                meanMs, p50Ms, p90Ms, p99Ms, p999Ms, maxMs,
+                contactsPerStep;
+    size_t      peakMemoryGrowth;                                   // Highest resident memory over what there was before the scene
+    bool        hasCounters;                                        // Whether the counters below were read
+    bool        hasEvent[PERF_EVENT_COUNT];
+    double      counters[PERF_PHASE_COUNT][PERF_EVENT_COUNT];       // Mean count per step
+};
+
+
+/**
+ *  Small deterministic random generator (xorshift), so scenes are the same on every platform
+ */
+static float randomFloat(unsigned& state, float lo, float hi) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return lo + (hi - lo) * (float)(state & 0xFFFFFF) / (float)0xFFFFFF;
+}
+
+
+/**
+ *  Adds a static box
+ */
+static int addStaticBox(World& world, float x, float y, float halfWidth, float halfHeight) {
+    BodyDef def;
+    def.dynamic = false;
+    def.shape   = makeBox(halfWidth, halfHeight);
+    def.posX    = x;
+    def.posY    = y;
+    return world.createBody(def);
+}
+
+
+/**
+ *  A pyramid of boxes with a base of 40 boxes
+ */
+static void buildPyramid(World& world) {
+    const int base = 40;
+    addStaticBox(world, 0.f, -0.5f, 50.f, 0.5f);
+
+    BodyDef def;
+    def.shape = makeBox(0.5f, 0.5f);
+    for (int row = 0; row < base; row++) {
+        for (int i = 0; i < base - row; i++) {
+            def.posX = (i - (base - row) / 2.f) * 1.05f;
+            def.posY = 0.5f + row * 1.f;
+            world.createBody(def);
+        }
+    }
+}
+
+
+/**
+ *  50 000 circles raining down onto the ground
+ */
+static void buildRain(World& world) {
+    const int columns = 250, rows = 200;
+    addStaticBox(world, 0.f, -0.5f, 80.f, 0.5f);
+
+    unsigned seed = 12345;
+    BodyDef def;
+    def.shape = makeCircle(0.2f);
+    for (int row = 0; row < rows; row++) {
+        for (int i = 0; i < columns; i++) {
+            def.posX = (i - columns / 2.f) * 0.5f + randomFloat(seed, -0.05f, 0.05f);
+            def.posY = 5.f + row * 0.5f;
+            def.velY = randomFloat(seed, -2.f, 0.f);
+            world.createBody(def);
+        }
+    }
+}
+
+
+/**
+ *  20 hanging chains of 100 links each, connected by revolute joints
+ */
+static void buildChain(World& world) {
+    const int chains = 20, links = 100;
+    addStaticBox(world, 0.f, -60.f, 200.f, 0.5f);
+
+    // The anchors overlap the first link, so they're kept out of the links' mask too, or a
+    // deep contact would fight the joint from the start
+    BodyDef anchor;
+    anchor.dynamic        = false;
+    anchor.shape          = makeBox(0.1f, 0.1f);
+    anchor.filterCategory = 0x0004;
+
+    BodyDef def;
+    def.shape          = makeBox(0.25f, 0.05f);
+    def.filterCategory = 0x0002;        // Links don't collide with each other
+    def.filterMask     = 0x0001;
+    for (int c = 0; c < chains; c++) {
+        float x0    = (c - chains / 2.f) * 4.f;
+        anchor.posX = x0;
+        int   prev  = world.createBody(anchor);
+        for (int i = 0; i < links; i++) {
+            def.posX = x0 + 0.25f + 0.5f * i;
+            def.posY = 0.f;
+            int link = world.createBody(def);
+            world.createJoint(prev, link, x0 + 0.5f * i, 0.f);
+            prev = link;
+        }
+    }
+}
+
+
+/**
+ *  A large pile of boxes, circles, triangles and pentagons in a container
+ */
+static void buildPile(World& world) {
+    const int columns = 40, rows = 100;
+    addStaticBox(world,   0.f, -0.5f, 25.f, 0.5f);
+    addStaticBox(world, -25.f, 50.f,  0.5f, 50.f);
+    addStaticBox(world,  25.f, 50.f,  0.5f, 50.f);
+
+    // The shapes to pick from
+    Vec2 triangle[3] = { Vec2(-0.4f, -0.3f), Vec2(0.4f, -0.3f), Vec2(0.f, 0.4f) };
+    Vec2 pentagon[5];
+    for (int i = 0; i < 5; i++)
+        pentagon[i] = Vec2(0.4f * cos(i * 1.2566f), 0.4f * sin(i * 1.2566f));
+    Shape shapes[4] = { makeBox(0.35f, 0.35f), makeCircle(0.35f), makePolygon(triangle, 3), makePolygon(pentagon, 5) };
+
+    unsigned seed = 777;
+    BodyDef def;
+    for (int row = 0; row < rows; row++) {
+        for (int i = 0; i < columns; i++) {
+            def.shape = shapes[(row * columns + i) % 4];
+            def.posX  = (i - columns / 2.f) * 1.1f + 0.5f;
+            def.posY  = 1.f + row * 1.1f;
+            def.angle = randomFloat(seed, 0.f, 6.28f);
+            world.createBody(def);
+        }
+    }
+}
+
+
+/**
+ *  10 000 boxes in small resting stacks, which fall asleep after half a second
+ */
+static void buildSleeping(World& world) {
+    const int stacks = 2000, height = 5;
+    addStaticBox(world, 0.f, -0.5f, stacks * 0.75f + 2.f, 0.5f);
+
+    BodyDef def;
+    def.shape = makeBox(0.5f, 0.5f);
+    for (int s = 0; s < stacks; s++) {
+        for (int i = 0; i < height; i++) {
+            def.posX = (s - stacks / 2.f) * 1.5f;
+            def.posY = 0.5f + i * 1.f;
+            world.createBody(def);
+        }
+    }
+}
+
+
+/**
+ *  A pile of compound bodies: L-shapes of two boxes and a ball, with a proxy per shape,
+ *  and combs of 16 teeth, with one proxy and a tree each
+ */
+static void buildCompound(World& world) {
+    const int columns = 20, rows = 40;
+    addStaticBox(world,   0.f, -0.5f, 35.f, 0.5f);
+    addStaticBox(world, -35.f, 50.f,  0.5f, 50.f);
+    addStaticBox(world,  35.f, 50.f,  0.5f, 50.f);
+
+    BodyDef lShape, comb;
+    lShape.compound.push_back(makeBox(0.6f, 0.2f, Vec2( 0.f,  -0.4f)));
+    lShape.compound.push_back(makeBox(0.2f, 0.4f, Vec2(-0.4f,  0.2f)));
+    lShape.compound.push_back(makeCircle(0.2f, Vec2(0.4f, 0.05f)));
+    comb.compound.push_back(makeBox(1.6f, 0.15f));
+    for (int i = 0; i < 16; i++)
+        comb.compound.push_back(makeBox(0.06f, 0.25f, Vec2(-1.5f + 0.2f * i, -0.4f)));
+
+    unsigned seed = 4242;
+    for (int row = 0; row < rows; row++) {
+        for (int i = 0; i < columns; i++) {
+            BodyDef& def = (row + i) % 3 == 0 ? comb : lShape;
+            def.posX  = (i - columns / 2.f) * 3.3f + 1.6f;
+            def.posY  = 1.f + row * 1.5f;
+            def.angle = randomFloat(seed, -0.3f, 0.3f);
+            world.createBody(def);
+        }
+    }
+}
+
+
+/**
+ *  3 000 boxes and circles sliding down a 400 x 60 tile level of slopes, steps and platforms,
+ *  whose outlines are one static body kept out of the broadphase
+ */
+static void buildTilemap(World& world) {
+    const int width = 400, height = 60, columns = 100, rows = 30;
+    Tilemap map;
+    map.create(width, height, 0.5f);
+
+    // Ground stepping down to the right, with walls at the ends and rows of platforms
+    unsigned seed = 999;
+    for (int x = 0; x < width; x++) {
+        int ground = 20 - x / 25 + (x / 7) % 2;
+        for (int y = 0; y < ground; y++)
+            map.setSolid(x, y, true);
+        if (x < 2 || x >= width - 2)
+            for (int y = 0; y < height; y++)
+                map.setSolid(x, y, true);
+    }
+    for (int p = 0; p < 40; p++) {
+        int x0 = (int)randomFloat(seed, 5.f, width - 15.f), y = (int)randomFloat(seed, 25.f, 45.f);
+        for (int x = x0; x < x0 + 8; x++)
+            map.setSolid(x, y, true);
+    }
+    map.createBody(world, -width * 0.25f, 0.f);
+
+    BodyDef box, ball;
+    box.shape  = makeBox(0.3f, 0.3f);
+    ball.shape = makeCircle(0.3f);
+    for (int row = 0; row < rows; row++) {
+        for (int i = 0; i < columns; i++) {
+            BodyDef& def = (row + i) % 2 ? box : ball;
+            def.posX = (i - columns / 2.f) * 1.8f + 0.5f;
+            def.posY = 24.f + row * 0.9f;
+            def.velX = randomFloat(seed, -1.f, 1.f);
+            world.createBody(def);
+        }
+    }
+}
+
+
+static const BenchScene scenes[] = {
+    { "pyramid",  buildPyramid,  600 },
+    { "rain",     buildRain,     300 },
+    { "chain",    buildChain,    600 },
+    { "pile",     buildPile,     600 },
+    { "sleeping", buildSleeping, 600 },
+    { "compound", buildCompound, 600 },
+    { "tilemap",  buildTilemap,  600 },
+};
+
+
+/**
+ *  Gets the resident memory of the process in bytes. The process's peak only ever goes up, so
+ *  scenes sample the current amount instead, to get their own high-water mark.
+ */
+static size_t getResidentMemory() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.WorkingSetSize;
+    return 0;
+#elif defined(__linux__)
+    long  size = 0, resident = 0;
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+    if (fscanf(file, "%ld %ld", &size, &resident) != 2) resident = 0;
+    fclose(file);
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+#else
+    // Only the process's peak is available here, in bytes on macOS
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (size_t)usage.ru_maxrss;
+#endif
+}
+
+
+/**
+ *  Builds a scene and steps it, timing every step
+ *  @param scene - The scene
+ *  @param steps - How many steps to run (0 = the scene's default)
+ *  @param counters - Hardware counters to attribute to each phase, or null
+ *  @param stats - Where the step times are recorded
+ */
+static BenchResult runScene(const BenchScene& scene, int steps, PerfCounters* counters, FrameStats& stats) {
+    typedef std::chrono::steady_clock clock;
+
+    BenchResult result;
+    result.name  = scene.name;
+    result.steps = steps > 0 ? steps : scene.steps;
+
+    PROFILE_THREAD_NAME("bench");
+#ifdef __GLIBC__
+    malloc_trim(0);     // Hand the last scene's freed heap back, or this one reuses it without it showing
+#endif
+    size_t baseMemory = getResidentMemory(), peakMemory = baseMemory;
+    World  world(0.f, -10.f);
+    auto start = clock::now();
+    scene.build(world);
+    if (counters) counters->reset();
+    world.setPerfCounters(counters);
+    result.buildMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    peakMemory     = std::max(peakMemory, getResidentMemory());
+
+    // Step with a fixed timestep
+    stats.reset();
+    start = clock::now();
+    double contacts = 0.0;
+    for (int i = 0; i < result.steps; i++) {
+        {
+            StatTimer timer(stats, STAT_STEP);
+            world.step(1.f / 60.f);
+        }
+        contacts  += world.getContactCount();
+        peakMemory = std::max(peakMemory, getResidentMemory());
+        stats.update(std::chrono::duration<double>(clock::now() - start).count());
+    }
+
+    // Statistics
+    const Histogram& times = stats.getTotal(STAT_STEP);
+    result.bodies          = world.getBodyCount();
+    result.joints          = world.getJointCount();
+    result.awakeAtEnd      = world.getAwakeBodyCount();
+    result.meanMs          = times.getMean();
+    result.p50Ms           = times.getPercentile(50.0);
+    result.p90Ms           = times.getPercentile(90.0);
+    result.p99Ms           = times.getPercentile(99.0);
+    result.p999Ms          = times.getPercentile(99.9);
+    result.maxMs           = times.getMax();
+    result.contactsPerStep = contacts / result.steps;
+    result.peakMemoryGrowth = peakMemory - baseMemory;
+
+    result.hasCounters = counters != nullptr;
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        result.hasEvent[e] = counters && counters->hasEvent((PerfEvent)e);
+        for (int p = 0; p < PERF_PHASE_COUNT; p++)
+            result.counters[p][e] = counters ? (double)counters->getTotal((PerfPhase)p, (PerfEvent)e) / result.steps : 0.0;
+    }
+    return result;
+}
+
+
+/**
+ *  Writes the mean hardware counts per step of each phase as a JSON object, or null
+ */
+static void writeCounters(FILE* file, const BenchResult& r) {
+    if (!r.hasCounters) {
+        fprintf(file, "null");
+        return;
+    }
+
+    fprintf(file, "{\n");
+    for (int p = 0; p < PERF_PHASE_COUNT; p++) {
+        fprintf(file, "        \"%s\": {", PerfCounters::getPhaseName((PerfPhase)p));
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            fprintf(file, "%s\"%s\": ", e ? ", " : " ", PerfCounters::getEventName((PerfEvent)e));
+            if (r.hasEvent[e]) fprintf(file, "%.0f", r.counters[p][e]);
+            else               fprintf(file, "null");
+        }
+        fprintf(file, " }%s\n", p + 1 < PERF_PHASE_COUNT ? "," : "");
+    }
+    fprintf(file, "      }");
+}
+
+
+/**
+ *  Prints the counters of each phase: instructions per cycle and misses per thousand instructions
+ */
+static void printCounters(const BenchResult& r) {
+    printf("  %-12s %14s %6s %13s %13s\n", "phase", "cycles/step", "IPC", "LLC miss/ki", "br miss/ki");
+    for (int p = 0; p < PERF_PHASE_COUNT; p++) {
+        const double* c = r.counters[p];
+        double kilo = c[PERF_INSTRUCTIONS] / 1000.0;
+        printf("  %-12s %14.0f %6.2f %13.2f %13.2f\n", PerfCounters::getPhaseName((PerfPhase)p), c[PERF_CYCLES],
+               c[PERF_CYCLES]     > 0.0 ? c[PERF_INSTRUCTIONS] / c[PERF_CYCLES] : 0.0,
+               kilo > 0.0 ? c[PERF_LLC_MISSES] / kilo : 0.0,
+               kilo > 0.0 ? c[PERF_BRANCH_MISSES] / kilo : 0.0);
+    }
+}
+
+
+/**
+ *  Writes the results as JSON, so they can be compared between releases
+ */
+static bool writeJson(const std::vector<BenchResult>& results, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+
+    fprintf(file, "{\n  \"scenes\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        fprintf(file,
+            "    {\n"
+            "      \"name\": \"%s\",\n"
+            "      \"bodies\": %d,\n"
+            "      \"joints\": %d,\n"
+            "      \"steps\": %d,\n"
+            "      \"build_ms\": %.3f,\n"
+            "      \"ms_per_step\": { \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"p99.9\": %.4f, \"max\": %.4f },\n"
+            "      \"contacts_per_step\": %.1f,\n"
+            "      \"awake_bodies_at_end\": %d,\n"
+            "      \"peak_memory_growth_bytes\": %zu,\n"
+            "      \"counters_per_step\": ",
+            r.name.c_str(), r.bodies, r.joints, r.steps, r.buildMs,
+            r.meanMs, r.p50Ms, r.p90Ms, r.p99Ms, r.p999Ms, r.maxMs,
+            r.contactsPerStep, r.awakeAtEnd, r.peakMemoryGrowth);
+        writeCounters(file, r);
+        fprintf(file, "\n    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    return true;
+}
+
+
+/**
+ *  Runs the benchmark scenes headlessly.
+ *  Usage: rbphys_bench [--scene name]... [--steps N] [--out results.json] [--trace trace.json] [--counters]
+ *                       [--log-interval seconds]
+ */
+int main(int argc, char** argv) {
+    std::vector<std::string> selected;
+    int         steps     = 0;
+    const char* outPath   = "bench_results.json";
+    const char* tracePath = nullptr;
+    bool        useCounters = false;
+    double      logInterval = 0.0;
+
+    // Parse arguments
+    for (int i = 1; i < argc; i++) {
+        if      (!strcmp(argv[i], "--scene") && i + 1 < argc)  selected.push_back(argv[++i]);
+        else if (!strcmp(argv[i], "--steps") && i + 1 < argc)  steps = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--out")   && i + 1 < argc)  outPath = argv[++i];
+        else if (!strcmp(argv[i], "--trace") && i + 1 < argc)  tracePath = argv[++i];
+        else if (!strcmp(argv[i], "--counters"))               useCounters = true;
+        else if (!strcmp(argv[i], "--log-interval") && i + 1 < argc) logInterval = atof(argv[++i]);
+        else {
+            fprintf(stderr, "Usage: %s [--scene name]... [--steps N] [--out results.json] [--trace trace.json] [--counters] [--log-interval seconds]\n", argv[0]);
+            fprintf(stderr, "Scenes:");
+            for (const BenchScene& scene : scenes) fprintf(stderr, " %s", scene.name);
+            fprintf(stderr, "\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Hardware counters are opt-in, since reading them at every phase boundary costs a few syscalls
+    PerfCounters counters;
+    if (useCounters && !counters.open()) {
+        fprintf(stderr, "Hardware counters are unavailable (not Linux, no PMU, or perf_event_paranoid > 2)\n");
+        useCounters = false;
+    }
+
+    // Tail latencies of the window can be logged while long scenes run
+    FrameStats stats(logInterval);
+
+    // Run the scenes
+    std::vector<BenchResult> results;
+    printf("%-10s %7s %6s %9s %9s %9s %9s %9s %10s %9s\n",
+           "scene", "bodies", "steps", "mean ms", "p50 ms", "p99 ms", "p99.9 ms", "max ms", "contacts", "+peak MB");
+    for (const BenchScene& scene : scenes) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), scene.name) == selected.end())
+            continue;
+
+        BenchResult r = runScene(scene, steps, useCounters ? &counters : nullptr, stats);
+        printf("%-10s %7d %6d %9.3f %9.3f %9.3f %9.3f %9.3f %10.1f %9.1f\n",
+               r.name.c_str(), r.bodies, r.steps, r.meanMs, r.p50Ms, r.p99Ms, r.p999Ms, r.maxMs,
+               r.contactsPerStep, r.peakMemoryGrowth / (1024.0 * 1024.0));
+        if (r.hasCounters) printCounters(r);
+        fflush(stdout);
+        results.push_back(r);
+    }
+
+    if (!writeJson(results, outPath)) {
+        fprintf(stderr, "Could not write %s\n", outPath);
+        return EXIT_FAILURE;
+    }
+    printf("Results written to %s\n", outPath);
+
+    // Profiler zones of the last steps, when the profiler is compiled in
+    if (tracePath) {
+        if (PROFILE_EXPORT(tracePath)) printf("Trace written to %s\n", tracePath);
+        else                           fprintf(stderr, "No trace written, the profiler isn't enabled in this build\n");
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+#include "AssetPack.h"
+#include "TextureFile.h"
+#include "stb_image.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+/**
+ *  Gets the file name of a path, which is what it is found by in a pack
+ */
+static std::string getBaseName(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+
+/**
+ *  Sums the pixels of an asset, so both ways of loading it actually read it
+ */
+static uint64_t loadAsset(const std::string& name, const unsigned char* data, size_t size, const char* path) {
+    uint64_t sum = 0;
+    if (TextureFile::isTextureFile(name.c_str())) {
+        TextureFile file;
+        if (data ? !file.open(data, size) : !file.read(path)) return 0;
+        for (int i = 0; i < file.getLevelCount(); i++) {
+            const unsigned char* pixels = file.getPixels(i);
+            for (uint32_t j = 0; j < file.getLevel(i).size; j += 64) sum += pixels[j];
+        }
+        return sum;
+    }
+
+    int width, height, channels;
+    unsigned char* pixels = data ? stbi_load_from_memory(data, (int)size, &width, &height, &channels, 4)
+                                 : stbi_load(path, &width, &height, &channels, 4);
+    if (!pixels) return 0;
+    for (size_t j = 0; j < (size_t)width * height * 4; j += 64) sum += pixels[j];
+    stbi_image_free(pixels);
+    return sum;
+}
+
+
+/**
+ *  Times loading every asset of a pack from the pack, then from the loose files it was made from
+ *  @param packPath - The pack
+ *  @param directory - Where the loose files are
+ */
+static int measure(const char* packPath, const std::string& directory) {
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point start = Clock::now();
+    AssetPack pack;
+    if (!pack.open(packPath)) return EXIT_FAILURE;
+    uint64_t packSum = 0;
+    for (int i = 0; i < pack.getCount(); i++) {
+        std::string name = pack.getName(i);
+        Asset asset;
+        pack.find(name, asset);
+        packSum += loadAsset(name, asset.data, asset.size, nullptr);
+    }
+    double packMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    start = Clock::now();
+    uint64_t looseSum = 0;
+    for (int i = 0; i < pack.getCount(); i++) {
+        std::string name = pack.getName(i);
+        looseSum += loadAsset(name, nullptr, 0, (directory + "/" + name).c_str());
+    }
+    double looseMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    printf("%d assets: %.2f ms from %s, %.2f ms from loose files in %s%s\n", pack.getCount(),
+           packMs, packPath, looseMs, directory.c_str(), packSum == looseSum ? "" : " (contents differ)");
+    return packSum == looseSum ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/**
+ *  Cooks an image into a texture file (see TextureFile), run by the build for every asset.
+ *  Usage: rbphys_cook input.png output.rbtex [--alpha-threshold N] [--no-mipmaps]
+ *         rbphys_cook --pack output.rbpk files...      Packs files (see AssetPack), named by their file names
+ *         rbphys_cook --measure pack.rbpk directory    Times loading a pack against the loose files in directory
+ */
+int main(int argc, char** argv) {
+    if (argc >= 3 && !strcmp(argv[1], "--pack")) {
+        std::vector<std::string> names, files;
+        for (int i = 3; i < argc; i++) {
+            files.push_back(argv[i]);
+            names.push_back(getBaseName(argv[i]));
+        }
+        if (!AssetPack::write(argv[2], names, files)) return EXIT_FAILURE;
+        printf("%d assets -> %s\n", (int)files.size(), argv[2]);
+        return EXIT_SUCCESS;
+    }
+    if (argc == 4 && !strcmp(argv[1], "--measure")) {
+        stbi_set_flip_vertically_on_load(true);
+        return measure(argv[2], argv[3]);
+    }
+
+    const char* inPath         = nullptr;
+    const char* outPath        = nullptr;
+    int         alphaThreshold = 128;
+    bool        mipmaps        = true;
+
+    // Parse arguments
+    for (int i = 1; i < argc; i++) {
+        if      (!strcmp(argv[i], "--alpha-threshold") && i + 1 < argc)  alphaThreshold = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--no-mipmaps"))                      mipmaps = false;
+        else if (argv[i][0] != '-' && !inPath)                          inPath = argv[i];
+        else if (argv[i][0] != '-' && !outPath)                         outPath = argv[i];
+        else {
+            inPath = nullptr;
+            break;
+        }
+    }
+    if (!inPath || !outPath) {
+        fprintf(stderr, "Usage: %s input.png output.rbtex [--alpha-threshold N] [--no-mipmaps]\n"
+                        "       %s --pack output.rbpk files...\n"
+                        "       %s --measure pack.rbpk directory\n", argv[0], argv[0], argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Bottom row first, the way the renderer loads images
+    stbi_set_flip_vertically_on_load(true);
+    int width, height, channels;
+    unsigned char* pixels = stbi_load(inPath, &width, &height, &channels, 4);
+    if (!pixels) {
+        fprintf(stderr, "Could not load %s: %s\n", inPath, stbi_failure_reason());
+        return EXIT_FAILURE;
+    }
+
+    bool ok = TextureFile::write(outPath, pixels, width, height, alphaThreshold, mipmaps);
+    stbi_image_free(pixels);
+    if (!ok) return EXIT_FAILURE;
+
+    TextureFile check;
+    if (!check.read(outPath)) return EXIT_FAILURE;
+    printf("%s -> %s: %dx%d, %d levels\n", inPath, outPath, width, height, check.getLevelCount());
+    return EXIT_SUCCESS;
+}
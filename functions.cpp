@@ -1,4 +1,5 @@
 #include "functions.h"
+#include "GLState.h"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -102,11 +103,11 @@ void CleanVAO(GLuint& vao, GLuint* eboId) {
     std::set<GLuint> vbos;
 
     if (eboId != nullptr) {
-        glDeleteBuffers(1, eboId);
+        GLState::deleteBuffers(1, eboId);
     }
 
     glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &nAttr);
-    glBindVertexArray(vao);
+    GLState::bindVertexArray(vao);
 
     for (int iAttr = 0; iAttr < nAttr; ++iAttr)
     {
@@ -122,10 +123,10 @@ void CleanVAO(GLuint& vao, GLuint* eboId) {
 
     for (auto vbo : vbos)
     {
-        glDeleteBuffers(1, &vbo);
+        GLState::deleteBuffers(1, &vbo);
     }
 
-    glDeleteVertexArrays(1, &vao);
+    GLState::deleteVertexArrays(1, &vao);
 }
 
 
@@ -1,15 +1,57 @@
-#include "glm/glm.hpp"
-#include "glm/gtc/matrix_transform.hpp"
-#include "glm/gtc/type_ptr.hpp"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include "shaders/spriteShader.h"
+#include "shaders/spriteBatchShader.h"
 #include "functions.h"
+#include "GLState.h"
 #include "Window.h"
 #include "Sprite.h"
+#include "SpriteBatch.h"
+#include "RenderQueue.h"
+#include "AssetPack.h"
+#include "ColliderCache.h"
+#include "TextureAtlas.h"
+#include "TextureCache.h"
+#include "TextureLoader.h"
+#include "ThreadPool.h"
+#include "ShaderRegistry.h"
+#include "World.h"
+#include "Profiler.h"
+#include "PerfCounters.h"
+#include "Stats.h"
+#include "SimulationThread.h"
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/**
+ *  Formats instructions per cycle and LLC misses per thousand instructions of each phase
+ *  @return The window title, empty if the counters couldn't be opened
+ */
+static std::string formatCounters(PerfCounters& counters) {
+    if (!counters.isOpen()) return "";
+
+    char title[256];
+    int  length = snprintf(title, sizeof(title), "Assignment 1 |");
+    for (int p = 0; p < PERF_PHASE_COUNT && length < (int)sizeof(title); p++) {
+        double cycles       = (double)counters.getTotal((PerfPhase)p, PERF_CYCLES),
+               instructions = (double)counters.getTotal((PerfPhase)p, PERF_INSTRUCTIONS),
+               llcMisses    = (double)counters.getTotal((PerfPhase)p, PERF_LLC_MISSES);
+        length += snprintf(title + length, sizeof(title) - length, " %s IPC %.2f LLC/ki %.2f |",
+                           PerfCounters::getPhaseName((PerfPhase)p),
+                           cycles > 0.0 ? instructions / cycles : 0.0,
+                           instructions > 0.0 ? llcMisses * 1000.0 / instructions : 0.0);
+    }
+    return title;
+}
 
 
 /**
@@ -37,22 +79,114 @@ int main()
         return EXIT_FAILURE;
     }
 
+    // Every asset in one file mapped at once when the build packed them, otherwise loose files.
+    // Declared before the workers, which read from it.
+    AssetPack assets;
+    bool      packed = assets.open("./../assets.rbpk");
+
+    // Images are decoded on worker threads and uploaded a few per frame
+    ThreadPool    workers;
+    TextureLoader textureLoader(workers);
+
+    // Sprites of the same image share one texture
+    TextureCache textureCache(64 * 1024 * 1024);
+    textureCache.setLoader(&textureLoader);
+    if (packed) {
+        textureLoader.setPack(&assets);
+        textureCache.setPack(&assets);
+    }
+    Sprite::setTextureCache(&textureCache);
+
+    // Shader programs, loaded from the binary cache after the first run
+    ShaderRegistry shaders;
+    ShaderProgram* shader      = shaders.get("sprite", spriteVertexShaderSrc, spriteFragmentShaderSrc);
+    ShaderProgram* batchShader = shaders.get("spriteBatch", spriteBatchVertexShaderSrc, spriteBatchFragmentShaderSrc);
+
+    // The image cooked by rbphys_cook when the build made one, otherwise the PNG
+    char image[] = "./../assets/example.rbtex";
+    if (packed) strcpy(image, "example.rbtex");
+    else if (FILE* cooked = fopen(image, "rb")) fclose(cooked);
+    else strcpy(image + strlen(image) - 5, "png");
+
+    // Collision shapes and pixel masks traced from the sprites' alpha
+    ColliderCache colliders;
+    if (packed) colliders.setPack(&assets);
+    Sprite::setColliderCache(&colliders);
+
     // Gameloop vars
-    GLuint      shader = CompileShader(spriteVertexShaderSrc, spriteFragmentShaderSrc);
     floatRect   texRect     (0.f,   0.f,    1.f,    1.f);
     intRect     spriteRect  (0,     0,      1,      1);
-    Sprite      sprite      ("./../assets/example.png", shader, texRect, spriteRect);
+    Sprite      sprite      (image, shader, texRect, spriteRect);
+    SpriteBatch batch       (batchShader);
+    RenderQueue queue       (batch);
+
+    // Pack the sprite images into an atlas, so all sprites share a texture
+    TextureAtlas atlas;
+    atlas.add(image, packed ? &assets : nullptr);
+    atlas.build();
+    sprite.useAtlas(atlas);
+
+    // Physics: a ground to land on and a box for the sprite
+    World       world(0.f, -2.f);
+    BodyDef     groundDef, boxDef;
+    groundDef.dynamic = false;
+    groundDef.shape   = makeBox(1.f, 0.05f);
+    groundDef.posY    = -0.95f;
+    boxDef.shape      = makeBox(sprite.getWidth() / 2.f, sprite.getHeight() / 2.f);
+
+    // The box's collider is traced from the sprite's alpha. An image that splits into several
+    // convex pieces makes a compound body.
+    std::vector<Shape> pieces;
+    colliders.get(image, texRect, spriteRect, 0, sprite.getWidth(), sprite.getHeight(), pieces);
+    if (pieces.size() == 1) boxDef.shape = pieces[0];
+    else                    boxDef.compound = pieces;
+
+    // Mass from the sprite's solid pixels; the body turns around their centre, and its
+    // snapshot transforms stay centred on the sprite's quad
+    if (const PixelMask* mask = sprite.getPixelMask())
+        boxDef.massData = mask->computeMassData(sprite.getWidth(), sprite.getHeight(), boxDef.density);
+    boxDef.posY       = 0.5f;
+    boxDef.angle      = 0.3f;
+    world.createBody(groundDef);
+    int box = world.createBody(boxDef);
+    float boxMass = world.getMass(box);
 
     float t = 0.f; // Total time elapsed since start of program
+    bool  p_down = false,
+          c_down = false;
+    bool  assetsReady = false;
+
+    // Hardware counter overlay, toggled with C and shown in the window title.
+    // The counters count the thread that opens them, so they live on the simulation thread.
+    PerfCounters counters;
+    bool         showCounters = false;
+    float        countersTime = 0.f;
+    std::future<std::string> countersTitle;
+
+    // Tail latencies, logged every 5 seconds
+    FrameStats   stats(5.0);
+    PROFILE_THREAD_NAME("main");
     windowManager.setAspectRatio(1.f);
     glClearColor(0.0f, 0.0f, 0.0f, 0.5f);
 
+    // From here on the world belongs to the simulation thread, and is only drawn from snapshots
+    SimulationThread simulation(world);
+    simulation.start();
+
     // Start gameloop
     GLFWwindow* window = windowManager.getWindow();
     while (!glfwWindowShouldClose(window)) {
         // time
         float dt = glfwGetTime() - t;
         t += dt;
+        if (t > dt) stats.record(STAT_FRAME, dt * 1000.0);    // The first frame includes start-up
+        if (stats.update(t)) {
+            // Alongside the frame times, how much GL state churn the tracker absorbed
+            uint64_t calls = GLState::getCallCount(), elided = GLState::getElidedCount();
+            printf("[stats] gl state: %llu calls, %llu elided (%.1f%%)\n", (unsigned long long)calls,
+                   (unsigned long long)elided, calls ? 100.0 * elided / calls : 0.0);
+            GLState::resetCounters();
+        }
 
         // Keys
         glfwPollEvents();
@@ -60,28 +194,97 @@ int main()
                 k_right = (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS),
                 k_up    = (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS),
                 k_down  = (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS),
-                k_f     = (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS);
+                k_f     = (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS),
+                k_p     = (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS),
+                k_c     = (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS);
+
+        // Export the profiler zones when P is pressed
+        if (k_p && !p_down && PROFILE_EXPORT("trace.json"))
+            std::cout << "Profiler trace written to trace.json" << '\n';
+        p_down = k_p;
+
+        // Toggle the counter overlay when C is pressed
+        if (k_c && !c_down) {
+            showCounters = !showCounters;
+            countersTime = t;
+            bool open    = showCounters;
+            simulation.post([&counters, open](World& world) {
+                if (open && counters.open()) counters.reset();
+                else if (open) std::cerr << "Hardware counters are unavailable" << '\n';
+                else counters.close();
+                world.setPerfCounters(counters.isOpen() ? &counters : nullptr);
+            });
+            if (!showCounters) glfwSetWindowTitle(window, "Assignment 1");
+        }
+        c_down = k_c;
 
         // Update windowManager
         windowManager.update(k_f);
 
+        // Upload the images that finished decoding
+        textureLoader.update();
+        if (!assetsReady && textureLoader.getPendingCount() == 0) {
+            assetsReady = true;
+            printf("[startup] assets ready after %.1f ms (%s)\n", glfwGetTime() * 1000.0, packed ? "pack" : "loose files");
+        }
+
         // Clear screen
         glClear(GL_COLOR_BUFFER_BIT);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        GLState::enable(GL_BLEND);
+        GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        // Update
-        sprite.draw();
+        // Move the box with the arrow keys
+        float impulse = boxMass * 4.f * dt;
+        if (k_right != k_left || k_up != k_down) {
+            float impulseX = impulse * (k_right - k_left),
+                  impulseY = impulse * (k_up - k_down);
+            simulation.post([box, impulseX, impulseY](World& world) {
+                world.applyImpulse(box, impulseX, impulseY);
+            });
+        }
+
+        // Draw the newest complete snapshot. Steps are timed on the simulation thread,
+        // and the ones published since the last frame are only sampled here.
+        if (simulation.update() && simulation.getSnapshot().step > 0)
+            stats.record(STAT_STEP, simulation.getSnapshot().stepMs);
+        sprite.setTransform(simulation.getSnapshot().transforms[box]);
+        {
+            PROFILE_ZONE("Sprite::draw");
+            StatTimer timer(stats, STAT_DRAW);
+            queue.begin();
+            sprite.draw(queue, 0);
+            queue.flush();
+        }
+
+        // Show the counters once a second, summarized on the simulation thread between steps
+        if (showCounters && t - countersTime >= 1.f) {
+            auto title = std::make_shared<std::promise<std::string>>();
+            countersTitle = title->get_future();
+            simulation.post([&counters, title](World&) {
+                title->set_value(formatCounters(counters));
+                counters.reset();
+            });
+            countersTime = t;
+        }
+        if (countersTitle.valid() && countersTitle.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            std::string title = countersTitle.get();
+            if (showCounters && !title.empty()) glfwSetWindowTitle(window, title.c_str());
+        }
 
         // Exit program when ESC is pressed
         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         {
+            simulation.stop();
             glfwTerminate();
             return EXIT_SUCCESS;
         }
 
         // Flip screen
-        glfwSwapBuffers(window);
+        {
+            PROFILE_ZONE("swap");
+            StatTimer timer(stats, STAT_SWAP);
+            glfwSwapBuffers(window);
+        }
 
         // Limit framerate to 60 fps
         while (glfwGetTime() < t + 1.0 / 60) {
@@ -90,7 +293,8 @@ int main()
     }
 
     // Return
-    glUseProgram(0);
+    simulation.stop();
+    GLState::useProgram(0);
     glfwTerminate();
     return EXIT_SUCCESS;
 }
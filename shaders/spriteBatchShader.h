@@ -0,0 +1,55 @@
+#ifndef __SPRITE_BATCH_SHADER_H_
+#define __SPRITE_BATCH_SHADER_H_
+#include <string>
+#include "spriteShader.h"
+
+static const std::string spriteBatchVertexShaderSrc = R"(
+#version 430 core
+layout(location = 0) in vec2 aPosition;
+layout(location = 1) in vec2 aTexCoord;
+
+/** Per-instance inputs */
+layout(location = 2) in vec4 iBasis;       // First two columns of the 3x2 transform
+layout(location = 3) in vec2 iOffset;      // Last column of the 3x2 transform
+layout(location = 4) in vec4 iTexRect;     // The spritesheet's rectangle in the texture
+layout(location = 5) in vec4 iTint;
+layout(location = 6) in ivec4 iSheetGrid;  // First column and row of the animation, columns and rows
+layout(location = 7) in uint iFrame;       // Animation step
+
+/** Outputs */
+out vec2 TexCoord;
+out vec4 Tint;
+)" + spriteFrameSrc + R"(
+void main()
+{
+	// Position
+	vec2 position = iBasis.xy * aPosition.x + iBasis.zw * aPosition.y + iOffset;
+	gl_Position = vec4(position, 1.0f, 1.0f);
+
+	// Texture coordinates of the instance's animation step
+	TexCoord = frameTexCoord(iTexRect, iSheetGrid, int(iFrame), aTexCoord);
+	Tint = iTint;
+}
+
+)";
+
+
+static const std::string spriteBatchFragmentShaderSrc = R"(
+#version 430 core
+
+/** Inputs */
+in vec2 TexCoord;
+in vec4 Tint;
+
+/** Outputs */
+out vec4 outColor;
+
+uniform sampler2D ourTexture;
+
+void main()
+{
+	outColor = texture(ourTexture, TexCoord) * Tint;
+}
+)";
+
+#endif
@@ -2,6 +2,24 @@
 #define __PACMAN_H_
 #include <string>
 
+/** Resolves an animation step to texture coordinates on a spritesheet, shared by the sprite shaders */
+static const std::string spriteFrameSrc = R"(
+// texRect: the spritesheet's rectangle in the texture (x0, y0, x1, y1)
+// grid: the first column and row of the animation, and its number of columns and rows
+vec2 frameTexCoord(vec4 texRect, ivec4 grid, int frame, vec2 quadTexCoord)
+{
+	ivec2 size = max(grid.zw, ivec2(1));
+	int   step = frame % (size.x * size.y);
+	vec2  tile = (texRect.zw - texRect.xy) / vec2(size);
+	vec2  cell = vec2(grid.x + step % size.x, grid.y + step / size.x);
+
+	// Rows are counted from the top of the sheet, so the top-left tile is the first step
+	vec2 origin = vec2(texRect.x + cell.x * tile.x, texRect.w - (cell.y + 1.0f) * tile.y);
+	return origin + quadTexCoord * tile;
+}
+)";
+
+
 static const std::string spriteVertexShaderSrc = R"(
 #version 430 core
 layout(location = 0) in vec2 aPosition;
@@ -11,15 +29,18 @@ layout(location = 2) in vec2 aTexCoord;
 out vec2 TexCoord;
 
 /** Uniforms */
-uniform mat4 u_TransformationMat;
-
+uniform mat3x2 u_TransformationMat;
+uniform vec4   u_TexRect;
+uniform ivec4  u_SheetGrid;
+uniform int    u_Frame;
+)" + spriteFrameSrc + R"(
 void main() 
 {
 	// Position
-	gl_Position = u_TransformationMat * vec4(aPosition, 1.0f, 1.0f);
+	gl_Position = vec4(u_TransformationMat * vec3(aPosition, 1.0f), 1.0f, 1.0f);
 
-	// Texture coordinates
-	TexCoord = aTexCoord;
+	// Texture coordinates of the current animation step
+	TexCoord = frameTexCoord(u_TexRect, u_SheetGrid, u_Frame, aTexCoord);
 }
 
 )";